@@ -0,0 +1,73 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/compiler_bench.dir/src/bench/bench.c.o"
+  "CMakeFiles/compiler_bench.dir/src/bench/bench.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/bench/generator.c.o"
+  "CMakeFiles/compiler_bench.dir/src/bench/generator.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/expressions/expr.c.o"
+  "CMakeFiles/compiler_bench.dir/src/expressions/expr.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/expressions/expr_token.c.o"
+  "CMakeFiles/compiler_bench.dir/src/expressions/expr_token.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/expressions/operator.c.o"
+  "CMakeFiles/compiler_bench.dir/src/expressions/operator.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/expressions/simplifier.c.o"
+  "CMakeFiles/compiler_bench.dir/src/expressions/simplifier.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/expressions/superinstruction.c.o"
+  "CMakeFiles/compiler_bench.dir/src/expressions/superinstruction.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/file_io/file.c.o"
+  "CMakeFiles/compiler_bench.dir/src/file_io/file.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/batch.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/batch.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/bytecode.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/bytecode.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/c_emitter.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/c_emitter.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/cache.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/cache.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/compilation.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/compilation.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/error.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/error.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/jit.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/jit.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/lexer.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/lexer.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/lexical.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/lexical.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/optimizer.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/optimizer.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/parallel_lexer.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/parallel_lexer.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/parser.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/parser.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/profile.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/profile.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/program.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/program.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/run.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/run.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/stream.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/stream.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/sweep.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/sweep.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/program/vm.c.o"
+  "CMakeFiles/compiler_bench.dir/src/program/vm.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/structures/arena.c.o"
+  "CMakeFiles/compiler_bench.dir/src/structures/arena.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/structures/list_double-ended.c.o"
+  "CMakeFiles/compiler_bench.dir/src/structures/list_double-ended.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/structures/prog_token_list.c.o"
+  "CMakeFiles/compiler_bench.dir/src/structures/prog_token_list.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/structures/queue.c.o"
+  "CMakeFiles/compiler_bench.dir/src/structures/queue.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/structures/stack.c.o"
+  "CMakeFiles/compiler_bench.dir/src/structures/stack.c.o.d"
+  "CMakeFiles/compiler_bench.dir/src/structures/task_pool.c.o"
+  "CMakeFiles/compiler_bench.dir/src/structures/task_pool.c.o.d"
+  "compiler_bench"
+  "compiler_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/compiler_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
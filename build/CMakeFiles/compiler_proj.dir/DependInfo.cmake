@@ -0,0 +1,49 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/expressions/expr.c" "CMakeFiles/compiler_proj.dir/src/expressions/expr.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/expressions/expr.c.o.d"
+  "/root/repo/src/expressions/expr_token.c" "CMakeFiles/compiler_proj.dir/src/expressions/expr_token.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/expressions/expr_token.c.o.d"
+  "/root/repo/src/expressions/operator.c" "CMakeFiles/compiler_proj.dir/src/expressions/operator.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/expressions/operator.c.o.d"
+  "/root/repo/src/expressions/simplifier.c" "CMakeFiles/compiler_proj.dir/src/expressions/simplifier.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/expressions/simplifier.c.o.d"
+  "/root/repo/src/expressions/superinstruction.c" "CMakeFiles/compiler_proj.dir/src/expressions/superinstruction.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/expressions/superinstruction.c.o.d"
+  "/root/repo/src/file_io/file.c" "CMakeFiles/compiler_proj.dir/src/file_io/file.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/file_io/file.c.o.d"
+  "/root/repo/src/main.c" "CMakeFiles/compiler_proj.dir/src/main.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/main.c.o.d"
+  "/root/repo/src/program/batch.c" "CMakeFiles/compiler_proj.dir/src/program/batch.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/batch.c.o.d"
+  "/root/repo/src/program/bytecode.c" "CMakeFiles/compiler_proj.dir/src/program/bytecode.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/bytecode.c.o.d"
+  "/root/repo/src/program/c_emitter.c" "CMakeFiles/compiler_proj.dir/src/program/c_emitter.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/c_emitter.c.o.d"
+  "/root/repo/src/program/cache.c" "CMakeFiles/compiler_proj.dir/src/program/cache.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/cache.c.o.d"
+  "/root/repo/src/program/compilation.c" "CMakeFiles/compiler_proj.dir/src/program/compilation.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/compilation.c.o.d"
+  "/root/repo/src/program/error.c" "CMakeFiles/compiler_proj.dir/src/program/error.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/error.c.o.d"
+  "/root/repo/src/program/jit.c" "CMakeFiles/compiler_proj.dir/src/program/jit.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/jit.c.o.d"
+  "/root/repo/src/program/lexer.c" "CMakeFiles/compiler_proj.dir/src/program/lexer.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/lexer.c.o.d"
+  "/root/repo/src/program/lexical.c" "CMakeFiles/compiler_proj.dir/src/program/lexical.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/lexical.c.o.d"
+  "/root/repo/src/program/optimizer.c" "CMakeFiles/compiler_proj.dir/src/program/optimizer.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/optimizer.c.o.d"
+  "/root/repo/src/program/parallel_lexer.c" "CMakeFiles/compiler_proj.dir/src/program/parallel_lexer.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/parallel_lexer.c.o.d"
+  "/root/repo/src/program/parser.c" "CMakeFiles/compiler_proj.dir/src/program/parser.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/parser.c.o.d"
+  "/root/repo/src/program/profile.c" "CMakeFiles/compiler_proj.dir/src/program/profile.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/profile.c.o.d"
+  "/root/repo/src/program/program.c" "CMakeFiles/compiler_proj.dir/src/program/program.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/program.c.o.d"
+  "/root/repo/src/program/run.c" "CMakeFiles/compiler_proj.dir/src/program/run.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/run.c.o.d"
+  "/root/repo/src/program/stream.c" "CMakeFiles/compiler_proj.dir/src/program/stream.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/stream.c.o.d"
+  "/root/repo/src/program/sweep.c" "CMakeFiles/compiler_proj.dir/src/program/sweep.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/sweep.c.o.d"
+  "/root/repo/src/program/vm.c" "CMakeFiles/compiler_proj.dir/src/program/vm.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/program/vm.c.o.d"
+  "/root/repo/src/structures/arena.c" "CMakeFiles/compiler_proj.dir/src/structures/arena.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/structures/arena.c.o.d"
+  "/root/repo/src/structures/list_double-ended.c" "CMakeFiles/compiler_proj.dir/src/structures/list_double-ended.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/structures/list_double-ended.c.o.d"
+  "/root/repo/src/structures/prog_token_list.c" "CMakeFiles/compiler_proj.dir/src/structures/prog_token_list.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/structures/prog_token_list.c.o.d"
+  "/root/repo/src/structures/queue.c" "CMakeFiles/compiler_proj.dir/src/structures/queue.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/structures/queue.c.o.d"
+  "/root/repo/src/structures/stack.c" "CMakeFiles/compiler_proj.dir/src/structures/stack.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/structures/stack.c.o.d"
+  "/root/repo/src/structures/task_pool.c" "CMakeFiles/compiler_proj.dir/src/structures/task_pool.c.o" "gcc" "CMakeFiles/compiler_proj.dir/src/structures/task_pool.c.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
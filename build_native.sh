@@ -0,0 +1,22 @@
+#!/bin/bash
+# Transpiles a program to C, then builds it into a native executable with the system C compiler
+# Usage: ./build_native.sh program.txt [executable]   (CC and CFLAGS can be set)
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 program.txt [executable]" >&2
+    exit 1
+fi
+program="$1"
+executable="${2:-${program%.txt}}"
+c_file="${executable}.c"
+
+# Build the compiler if needed
+if [ ! -x build/compiler_proj ]; then
+    ./build.sh > /dev/null
+fi
+
+# Transpile, then compile
+build/compiler_proj --emit-c="$c_file" "$program"
+${CC:-cc} ${CFLAGS:--O2} -o "$executable" "$c_file"
+echo "Built $executable"
@@ -0,0 +1,46 @@
+#!/bin/bash
+# Conformance of the transpiler: every program of the directory (code/ by default) is run by the interpreter
+# and as a native executable built from its C translation; stdout, stderr and the exit code must be identical
+# Usage: ./conformance.sh [directory]
+dir="${1:-code}"
+
+# Build the compiler if needed
+if [ ! -x build/compiler_proj ]; then
+    ./build.sh > /dev/null
+fi
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+failed=0
+total=0
+for program in "$dir"/*.txt; do
+    total=$((total + 1))
+    build/compiler_proj --no-export "$program" > "$tmp/expected.out" 2> "$tmp/expected.err"
+    expected_status=$?
+
+    # The diagnostics of the lexer and the parser are written by the transpiler, the output of the execution by
+    # the native program; a program that does not compile has only the output of the transpiler
+    build/compiler_proj --emit-c="$tmp/program.c" "$program" > "$tmp/actual.out" 2> "$tmp/actual.err"
+    actual_status=$?
+    if [ $actual_status -eq 0 ]; then
+        if ! ${CC:-cc} -O2 -o "$tmp/program" "$tmp/program.c"; then
+            echo "FAIL $program: cannot build the C translation"
+            failed=$((failed + 1))
+            continue
+        fi
+        "$tmp/program" >> "$tmp/actual.out" 2>> "$tmp/actual.err"
+        actual_status=$?
+    fi
+
+    if ! cmp -s "$tmp/expected.out" "$tmp/actual.out" || ! cmp -s "$tmp/expected.err" "$tmp/actual.err" \
+        || [ $expected_status -ne $actual_status ]; then
+        echo "FAIL $program"
+        diff "$tmp/expected.out" "$tmp/actual.out" | head -5
+        failed=$((failed + 1))
+    else
+        echo "ok   $program"
+    fi
+done
+
+echo "$((total - failed))/$total programs identical"
+[ $failed -eq 0 ]
@@ -0,0 +1,27 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Shapes of the generated programs
+typedef enum {
+    PROGRAM_STRAIGHT,       // long straight-line code: short assignments
+    PROGRAM_EXPRESSIONS,    // assignments of long expressions
+    PROGRAM_LOOPS,          // tight for and while loops of a few statements
+    PROGRAM_NESTED,         // deeply nested if/else blocks
+    NB_PROGRAM_SHAPES
+} e_program_shape;
+
+extern const char *const program_shape_names[NB_PROGRAM_SHAPES];
+
+// Returns the shape named name, NB_PROGRAM_SHAPES if there is none
+e_program_shape find_program_shape(const char *name);
+
+// Returns a valid program of the shape, of about size characters (at least one statement of the shape), written
+// in a buffer to free; its length is written in length
+// The same seed gives the same program. The variables start from the result of a loop the optimizer cannot
+// compute, so the program is not folded away: its execution time grows with its size, and it ends normally
+char *generate_program(e_program_shape shape, size_t size, uint64_t seed, size_t *length);
+
+#endif
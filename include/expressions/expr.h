@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include "expressions/expr_token.h"
 #include "structures/queue.h"
+#include "structures/arena.h"
+#include "expressions/superinstruction.h"
 
 typedef struct {
     t_list list;
@@ -28,39 +30,96 @@ void print_expr_file(FILE *file, const t_expr *expr);
 // Moves p_s past the int
 int parse_int(const char **p_s);
 
-// Converts the string s to an expression of type t_expr
-t_expr parse_expr(const char **s);
+// Converts the string s to an expression of type t_expr, whose tokens are allocated in the arena
+t_expr parse_expr(const char **s, t_arena *arena);
+
+// Slots of the variable table: the variables a to z, then the temporaries introduced by the optimizer
+#define NB_VARIABLES 26
+#define NB_TEMPORARIES 16
+#define NB_SLOTS (NB_VARIABLES + NB_TEMPORARIES)
+
+// Prints the name of the variable in the given slot: its letter, or t0, t1... for a temporary
+void print_variable_file(FILE *file, int slot);
+
+// Kinds of instructions of a compiled expression
+// A jump follows the left operand of each & and | whose right operand is not a single value: when the left operand
+// decides the result, the right operand and the operator are skipped (so a division by zero there is never done)
+// The strength reduction replaces an operator and its constant right operand by a unary instruction
+// (RPN_SQUARE and after, in the order of the superinstructions of SHAPE_VAR_SPECIAL)
+typedef enum {
+    RPN_CONST, RPN_VAR, RPN_OP,
+    RPN_AND_JUMP,   // a &: if a is 0, skips to the operator (a stays 0)
+    RPN_OR_JUMP,    // a |: if a is not 0, replaces it by 1 and skips to the operator
+    RPN_SQUARE,     // a ^ 2: a * a
+    RPN_CUBE,       // a ^ 3: a * a * a
+    RPN_SHL,        // a * 2^k: a << k
+    RPN_DIV_CONST   // a / d: shifts or a multiply-high, without the test of d
+} e_rpn_opcode;
+
+// Division by a constant d (not 0, 1, -1 or INT_MIN) without a division instruction
+// If |d| is a power of two 2^shift, magic is 0 and the quotient is a shift rounded toward zero;
+// otherwise the quotient is the high half of magic * a, corrected then shifted (Hacker's Delight, 10-1)
+typedef struct {
+    int divisor;
+    int magic;
+    int shift;
+} t_div_const;
+
+// Returns the division by the constant divisor (not 0, 1, -1 or INT_MIN)
+t_div_const div_const_of(int divisor);
+
+// Returns a / div->divisor, truncated toward zero as the division of apply_op()
+int apply_div_const(const t_div_const *div, int a);
 
+// Instruction of a compiled expression (only one field of arg is valid, depending on opcode)
 typedef struct {
-    t_expr expr;
+    e_rpn_opcode opcode;
+    union {
+        int val;            // RPN_CONST: value of the constant
+        int slot;           // RPN_VAR: slot of the variable in the variable table
+        operator_type op;   // RPN_OP: operator applied to the top of the stack
+        int shift;          // RPN_SHL: shift of the top of the stack
+        int skip;           // RPN_AND_JUMP, RPN_OR_JUMP: instructions skipped, up to the & or | included
+        t_div_const div;    // RPN_DIV_CONST: division of the top of the stack
+    } arg;
+} t_rpn_instr;
+
+// Expression in Reverse Polish notation, compiled into one contiguous buffer
+typedef struct {
+    t_rpn_instr *code;
+    int size;
+    int max_depth;  // maximum depth of the value stack during the evaluation
+    int super;      // superinstruction evaluating the expression (SUPER_ID), SUPER_GENERIC for the RPN loop
 } t_expr_rpn;
 
+// Computes the maximum depth of the value stack during the evaluation of the expression, the targets of its
+// jumps and its superinstruction: called after every change of the instructions
+void update_max_depth_rpn(t_expr_rpn *expr_rpn);
+
 // Returns the result of the evaluation of the expression expr, in Reverse Polish notation
+// No allocation: the value stack is a local array of expr->max_depth ints
+// Expressions with a superinstruction are evaluated by their fused code instead
 int eval_rpn(const int var_table[], const t_expr_rpn *expr);
 
-// Converts an expression in infix notation to Reverse Polish notation
-t_expr_rpn shunting_yard(t_expr *expr);
+// Prints the content of the RPN expression
+void print_expr_rpn(const t_expr_rpn *expr_rpn);
 
-// Returns the string between " " at the beginning of the string pointed at by p_s
+// Prints the content of the RPN expression in the given file
+void print_expr_rpn_file(FILE *file, const t_expr_rpn *expr_rpn);
+
+// Converts an expression in infix notation to Reverse Polish notation, allocated in the arena
+t_expr_rpn shunting_yard(t_expr *expr, t_arena *arena);
+
+// Returns the string between " " at the beginning of the string pointed at by p_s, allocated in the arena
 // Moves p_s past the string
-char* parse_string(const char **p_s);
+char* parse_string(const char **p_s, t_arena *arena);
 
 char* eval_string_expr(const t_expr *expr);
 
 // Returns true if the expression is a constant expression
 bool is_constant_expr_rpn(const t_expr_rpn *expr_rpn);
 
-// Simplifies constant subexpressions in an RPN expression
-// For example: [2, 3, +, x, +] becomes [5, x, +]
-//              [a, 4, 2, -, +] becomes [a, 2, +]
-// The original expression is modified in-place
-void simplify_constant_subexpressions_rpn(t_expr_rpn *expr_rpn);
-
-// Pre-computes a fully constant expression and returns result as a NUMBER token
-void precompute_constant_expr_rpn(t_expr_rpn *expr_rpn);
-
-// Destructor
+// Destructor (the tokens of an expression allocated in an arena are released with the arena)
 void destroy_expr(t_expr *expr);
-void destroy_expr_rpn(t_expr_rpn *expr_rpn);
 
 #endif
@@ -12,6 +12,9 @@ typedef enum {
 
 operator_type operator_of_char(char c);
 
+// Returns a ^ b
+int fast_exp(int a, int b);
+
 // Returns a op b
 int apply_op(operator_type op, int a, int b);
 
@@ -0,0 +1,19 @@
+#ifndef SIMPLIFIER_H
+#define SIMPLIFIER_H
+
+#include "expressions/expr.h"
+
+// Simplifies the expression in one pass over its tree, rewritten in place (it never grows)
+// - operators on constants are folded, except a division by zero or INT_MIN / -1; with report_division_by_zero
+//   (an expression of the source), a constant divided by a constant zero stops the compilation, otherwise (after
+//   the constant propagation) it is left to the execution
+// - identities: x + 0, x - 0, x * 1, x / 1, x ^ 1 and, for a boolean x, x & 1, x | 0, x X 0 give x;
+//   x * 0, x ^ 0, x & 0, x | 1, x - x, x == x... give a constant when x cannot stop the program;
+//   N N x gives a boolean x, N (a < b) gives a >= b; 0 & y gives 0 and 1 | y gives 1, y being skipped
+// - the constants of chains of + and - or of * are reassociated and folded: [2 x + 3 +] becomes [x 5 +]
+// - each & and | whose right operand is not a single value keeps a jump after its left operand
+// The arithmetic wraps modulo 2^32 as the execution: reassociation gives the same values
+// Stops the program on an empty or malformed expression (an operator without its operands)
+void simplify_expr_rpn(t_expr_rpn *expr_rpn, bool report_division_by_zero);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SUPERINSTRUCTION_H
+#define SUPERINSTRUCTION_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "expressions/operator.h"
+
+// Frequent shapes of expressions and statements, each one evaluated by its own fused code,
+// without the loop and the value stack of eval_rpn()
+typedef enum {
+    SHAPE_GENERIC,          // any other expression: RPN loop
+    SHAPE_CONST,            // c
+    SHAPE_VAR,              // x
+    SHAPE_VAR_OP_CONST,     // x op c
+    SHAPE_VAR_OP_VAR,       // x op y
+    SHAPE_CONST_OP_VAR,     // c op x
+    SHAPE_UPDATE,           // statement x = x + c or x = x - c, updated in place
+    SHAPE_VAR_SPECIAL,      // x followed by an instruction of the strength reduction (x ^ 2, x ^ 3, x << k, x / c),
+                            // numbered from RPN_SQUARE
+    NB_SHAPES
+} e_rpn_shape;
+
+#define NB_OPERATORS (XOR + 1)
+
+// Superinstruction: a shape and, for the binary shapes, its operator
+#define SUPER_ID(shape, op) ((shape) * NB_OPERATORS + (op))
+#define NB_SUPERINSTRUCTIONS (NB_SHAPES * NB_OPERATORS)
+#define SUPER_GENERIC SUPER_ID(SHAPE_GENERIC, 0)
+
+// Instrumentation: when enabled, every evaluation increments the counter of its superinstruction
+// The counters are shared by all threads, only enabled for one program at a time
+extern bool super_stats_enabled;
+extern unsigned long super_hits[NB_SUPERINSTRUCTIONS];
+
+// Prints the number of hits of each superinstruction used, most used first
+void print_super_stats(FILE *file);
+
+#endif
@@ -1,6 +1,23 @@
 #ifndef FILE_H
 #define FILE_H
 
-char *read_file(const char *file_name);
+#include <stdbool.h>
+#include <stddef.h>
 
-#endif
\ No newline at end of file
+// Source of a program, read-only
+typedef struct {
+    const char *data;   // size characters, always followed by a '\0'
+    size_t size;
+    void *map;          // region mapped in memory, NULL if data was read into a buffer
+    size_t map_size;
+} t_source;
+
+// Loads the file (stdin if file_name is "-"): regular files are mapped in memory without any copy,
+// pipes and other streams are read into a buffer
+// Returns false, after printing the error, if the file cannot be read
+bool load_source(const char *file_name, t_source *source);
+
+// Destructor
+void release_source(t_source *source);
+
+#endif
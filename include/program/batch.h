@@ -0,0 +1,32 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+
+#include "program/program.h"
+
+// Result of one script of a batch
+typedef struct {
+    const char *file_name;
+    char *output;           // everything written by print and return
+    size_t output_size;
+    char *errors;           // its diagnostics
+    size_t errors_size;
+    bool error;             // the script could not be read, compiled or executed until the end
+    double compile_ms;
+    double run_ms;
+} t_batch_script;
+
+// Returns the scripts to run: the files of paths, and the .txt files of the directories of paths (sorted by name)
+// The number of scripts is written in nb_files
+char **list_batch_files(char **paths, int nb_paths, int *nb_files);
+
+// Compiles and runs every script on a work-stealing pool of nb_threads threads
+// The outputs are written on stdout in the order of file_names, each followed by the diagnostics of its script on
+// stderr, then a summary with the timings on stderr
+// Returns the number of scripts that failed
+int run_batch(char **file_names, int nb_files, int nb_threads, const t_run_options *options);
+
+void destroy_batch_files(char **file_names, int nb_files);
+
+#endif
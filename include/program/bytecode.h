@@ -0,0 +1,57 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "program/program.h"
+
+// Opcodes of the virtual machine
+// OP_ADD .. OP_XOR follow the order of operator_type, so that OP_ADD + op is the opcode of op
+// OP_SQUARE .. OP_DIV_CONST follow the order of the specialized instructions, from RPN_SQUARE
+typedef enum {
+    OP_PUSH_CONST, OP_PUSH_VAR, OP_STORE_VAR,
+    OP_ADD, OP_SUB, OP_MULT, OP_DIV, OP_EXP,
+    OP_EQUAL, OP_DIFF, OP_LESS, OP_GREATER, OP_LEQ, OP_GEQ,
+    OP_AND, OP_OR, OP_NOT, OP_XOR,
+    OP_SQUARE, OP_CUBE, OP_SHL, OP_DIV_CONST,
+    OP_JUMP, OP_JUMP_IF_FALSE,
+    OP_AND_JUMP, OP_OR_JUMP,    // short-circuit of & and |: the value tested stays on the stack
+    OP_PRINT, OP_PRINT_STR, OP_RETURN, OP_HALT,
+    OP_ERROR,                   // malformed expression: prints the diagnostic at offset arg of the string pool
+    NB_OPCODES
+} e_opcode;
+
+// One instruction: the meaning of arg depends on the opcode
+// (constant, variable index, jump target, offset in the string pool, index in the division table)
+typedef struct {
+    int opcode;
+    int arg;
+} t_instr;
+
+// Flat program: contiguous instructions, jumps are indices in code
+typedef struct {
+    t_instr *code;
+    int size;
+    int capacity;
+    char *strings;      // string pool, NUL-terminated strings one after another
+    int strings_size;
+    int strings_capacity;
+    t_div_const *divs;  // division table: the divisors of OP_DIV_CONST with their magic number and shift
+    int nb_divs;
+    int divs_capacity;
+    int max_stack;      // maximum depth of the value stack
+} t_bytecode;
+
+// Lowers the AST into bytecode
+t_bytecode compile_bytecode(const t_ast *prog);
+
+// Returns true if the VM can run the bytecode, which it does without any check: the opcodes and their arguments
+// are in range, the division table holds the results of div_const_of(), every path ends with OP_RETURN, OP_HALT or OP_ERROR, and each instruction is reached with one depth
+// of the value stack, enough for its operands and at most max_stack
+bool is_valid_bytecode(const t_bytecode *bc);
+
+// Prints the bytecode (one instruction per line)
+void print_bytecode(FILE *file, const t_bytecode *bc);
+
+// Destructor
+void destroy_bytecode(t_bytecode *bc);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef C_EMITTER_H
+#define C_EMITTER_H
+
+#include "program/program.h"
+
+// Writes the program as a standalone C translation unit: variables are int locals, blocks are native C
+// if, while and for statements, operators keep the semantics of apply_op() (32-bit wrapping arithmetic,
+// fast_exp(), the division by zero stops the program)
+// Compiled and run, it writes the same output as run(), and exits with EXIT_FAILURE where run() stops on an error
+void emit_c_program(const t_ast *prog, const char *source_file_name, FILE *file);
+
+#endif
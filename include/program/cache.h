@@ -0,0 +1,54 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdint.h>
+
+#include "program/compilation.h"
+
+#define CACHE_MAGIC "ALSI-BC"
+
+// Bumped whenever the layout of the file, e_opcode or the meaning of an instruction changes
+// 2: variable slots of the temporaries of the optimizer
+// 3: specialized instructions of the strength reduction
+// 4: short-circuit jumps of & and |
+// 5: OP_ERROR of the malformed expressions
+// 6: division table, indexed by the argument of OP_DIV_CONST
+#define CACHE_VERSION 6
+
+// Header of a cache file, followed by the instructions, the division table then the string pool
+typedef struct {
+    char magic[8];              // CACHE_MAGIC
+    uint32_t version;           // CACHE_VERSION
+    uint32_t instr_size;        // sizeof(t_instr) of the compiler that wrote the file
+    uint64_t source_hash;       // hash_bytes() of the source
+    uint64_t source_size;
+    uint64_t payload_hash;      // hash of the instructions, of the division table and of the string pool
+    int32_t nb_instrs;
+    int32_t strings_size;
+    int32_t nb_divs;
+    int32_t max_stack;
+    uint32_t code_offset;       // offsets from the start of the file
+    uint32_t divs_offset;
+    uint32_t strings_offset;
+} t_cache_header;
+
+// 64-bit FNV-1a hash of the size first bytes of data
+uint64_t hash_bytes(const void *data, size_t size);
+
+// Writes in cache_file_name the name of the cache file of the source file (extension .bc)
+void get_cache_file_name(const char *source_file_name, char *cache_file_name, size_t size);
+
+// Returns the program stored in the cache file if it was built from the source s of size characters and its bytecode
+// is valid, NULL otherwise
+// The bytecode is used where it is mapped in memory, without any copy; the program has no AST
+t_program *load_program_cache(const char *cache_file_name, const char *s, size_t size);
+
+// Writes the bytecode of the program (compiled if needed) in the cache file, keyed by the source s
+// Returns false if the file could not be written
+bool save_program_cache(const char *cache_file_name, const char *s, size_t size, t_program *program);
+
+// Returns the program of the source s of size characters: from the cache file if it is up to date,
+// compiled otherwise, in which case the cache file is rebuilt unless the compilation wrote diagnostics
+t_program *compile_program_cached(const char *s, size_t size, const char *cache_file_name, int nb_lex_threads);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef COMPILATION_H
+#define COMPILATION_H
+
+#include "program/program.h"
+#include "program/bytecode.h"
+#include "program/jit.h"
+#include "program/optimizer.h"
+
+// Compiled program: lexed, parsed and optimized once, then run and exported any number of times
+typedef struct {
+    t_arena arena;          // owns the expressions, strings and AST nodes
+    t_ast *ast;             // NULL if the program was loaded from its cache file
+    t_ast *source_ast;      // AST before the optimization, for the export, NULL if it is not kept
+    t_opt_stats opt_stats;  // what the optimizer changed in the AST
+    bool has_bytecode;      // the bytecode is compiled the first time the VM runs the program
+    t_bytecode bytecode;
+    bool has_jit;           // the native code is generated the first time the JIT engine runs the program
+    t_jit_code jit;         // no code if the machine is not supported: the VM runs the program instead
+    void *cache_map;        // cache file mapped in memory, holding the bytecode, NULL if none
+    size_t cache_map_size;
+} t_program;
+
+// Compiles the program s of size characters (not used after the call)
+// Large sources are lexed on nb_lex_threads threads, the AST is optimized
+t_program *compile_program(const char *s, size_t size, int nb_lex_threads);
+
+// Same, for a program whose inputs (bit 1 << slot) do not start at 0: the optimizer does not assume their value
+t_program *compile_program_inputs(const char *s, size_t size, int nb_lex_threads, uint64_t inputs);
+
+// Same as compile_program(), keeping a copy of the AST before the optimization for export_compiled_program()
+t_program *compile_program_exported(const char *s, size_t size, int nb_lex_threads);
+
+// Compiles the program with the given inputs, with a copy of the AST before the optimization if keep_source_ast
+t_program *compile_program_with(const char *s, size_t size, int nb_lex_threads, uint64_t inputs, bool keep_source_ast);
+
+// Compiles the bytecode of the program, if it is not compiled yet
+void compile_program_bytecode(t_program *program);
+
+// Executes the compiled program with the engine of the options
+void run_compiled_program(t_program *program, const t_run_options *options);
+
+// Differential test: executes the program with the AST walker (reference) and with the engine of the options,
+// the two outputs and the errors must be identical
+// The output of the engine is written in the output of the options; the first difference is printed on stderr
+// An error of the engine is raised again once the outputs are compared
+// Returns true if the two executions are identical
+bool check_compiled_program(t_program *program, const t_run_options *options);
+
+// Exports the AST of the compiled program in a Mermaid file named after the source file
+// The AST is the one of the source if the program kept it (compile_program_exported()), the optimized one otherwise
+void export_compiled_program(const t_program *program, const char *source_file_name);
+
+// Executes the program with the AST walker, counting and timing each statement, then writes the profile in
+// <source>.profile.txt (statements sorted by time) and <source>.profile.mmd (Mermaid heatmap of the AST)
+// An error of the program is raised again once the profile is written
+void profile_compiled_program(t_program *program, const t_run_options *options, const char *source_file_name);
+
+// Destructor
+void destroy_program(t_program *program);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef ERROR_H
+#define ERROR_H
+
+#include <setjmp.h>
+#include <stdio.h>
+
+// Recovery point of the current thread, NULL if an error must exit the process
+extern _Thread_local jmp_buf *error_recovery;
+
+// Stream of the diagnostics of the current thread, NULL for stderr
+extern _Thread_local FILE *error_output;
+
+// Returns the stream where the diagnostics of the current thread are written
+FILE *error_stream();
+
+// Stops the compilation or the execution of the current program, after its error message was printed
+// Jumps back to the recovery point of the thread if there is one, exits the process otherwise
+_Noreturn void program_error();
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "program/bytecode.h"
+
+// Native code of a program, in memory mapped read-only and executable
+typedef struct {
+    void *code;
+    size_t size;    // size of the mapping
+} t_jit_code;
+
+// Returns true if the JIT can generate code for this machine (x86-64, System V calling convention)
+bool jit_supported();
+
+// Translates the bytecode into x86-64 machine code
+// Variables are read and written in a var_value block pinned in a register, the expression stack is
+// the machine stack with its top cached in a register; print and return call back into the runtime
+// A malformed expression stops the program when it is evaluated, with the diagnostic of eval_rpn()
+// Returns false if the machine is not supported or the bytecode cannot be translated: the caller runs the VM
+bool compile_jit(const t_bytecode *bc, t_jit_code *jit);
+
+// Executes the native code, all variables start at 0, print and return write in out
+void run_jit(const t_jit_code *jit, FILE *out);
+
+// Destructor
+void destroy_jit(t_jit_code *jit);
+
+#endif
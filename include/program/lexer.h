@@ -3,6 +3,34 @@
 
 #include "structures/prog_token_list.h"
 
-t_prog_token_list lex(const char *s);
+// State of the lexer between two characters of the source
+typedef struct {
+    bool await_expr;
+    bool await_endblock;
+    bool in_indent;
+    bool in_for;
+    bool skip_expr;
+    int nb_endblock_awaited;
+    int len_indent;
+    int curr_indent;
+} t_lexer_state;
+
+// Called by lex_range before the first character, and before every line that starts in column 0
+// s is the next character, nb_tokens the size of the token list; returning true stops the lexer at s
+typedef bool (*t_line_callback)(void *ctx, const char *s, const t_lexer_state *state, int nb_tokens);
+
+// State at the start of a program
+t_lexer_state lexer_initial_state();
+
+bool lexer_state_equal(const t_lexer_state *a, const t_lexer_state *b);
+
+// Lexes s from state until end (NULL: until the end of the string), appends the tokens to list
+// on_line may be NULL; returns the position where the lexer stopped, state is updated
+const char *lex_range(const char *s, const char *end, t_lexer_state *state, t_arena *arena,
+                      t_prog_token_list *list, t_line_callback on_line, void *ctx);
+
+// Returns the tokens of the program s of size characters (followed by a '\0')
+// The expressions are allocated in the arena
+t_prog_token_list lex(const char *s, size_t size, t_arena *arena);
 
 #endif
\ No newline at end of file
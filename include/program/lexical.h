@@ -28,8 +28,7 @@ typedef struct {
 } t_prog_token;
 
 void print_keyword(e_keyword keyword);
+void print_keyword_file(FILE *file, e_keyword keyword);
 void print_prog_token(const t_prog_token *token);
 
-void destroy_prog_token(t_prog_token *token);
-
 #endif
\ No newline at end of file
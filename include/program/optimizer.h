@@ -0,0 +1,59 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdint.h>
+
+#include "program/program.h"
+
+// What the optimization passes changed in the AST
+typedef struct {
+    int propagated;         // variable reads replaced by the constant value of the variable
+    int folded_ifs;         // If statements with a constant condition, replaced by the branch taken
+    int removed_loops;      // loops whose condition is false when they are reached
+    int closed_loops;       // counted loops replaced by the values of their variables when they exit
+    int removed_statements; // statements never reached, in dead branches, removed loops or after a return
+    int loops;              // loops examined by the hoisting
+    int hoisted;            // invariant subexpressions computed once before their loop, in a temporary
+    int reused;             // occurrences replaced by the temporary of an identical subexpression
+    int reduced;            // operators with a constant operand replaced by a cheaper instruction
+} t_opt_stats;
+
+// Constant propagation: the values of the variables known at compile time (all variables start at 0) are
+// propagated through straight-line code and branches, and replace the variables in the expressions
+// If statements with a constant condition are replaced by the branch taken, loops whose condition is false when
+// they are reached are removed, and so are the statements after a return or a loop that never exits
+// A loop that only assigns variables from known values, as polynomials of the iteration number (induction
+// variables, sums), and whose number of iterations follows from its condition is replaced by the final values
+// An operator that would stop the program is never folded: it stays for the execution
+// The inputs (bit 1 << slot) are the variables whose value at the start is unknown, given by each run of a sweep
+// The first statement can change
+void propagate_constants(t_ast **prog, uint64_t inputs, t_opt_stats *stats);
+
+// Loop-invariant code motion: in each While and For loop, the subexpressions that only read variables the loop
+// never assigns are computed once before the loop, in a temporary (slots NB_VARIABLES and above)
+// A subexpression that can stop the program (a division whose divisor is not a constant other than 0 and -1)
+// is never moved: the loop may not evaluate it
+// New nodes and expressions are allocated in the arena
+void hoist_loop_invariants(t_ast *prog, t_arena *arena, t_opt_stats *stats);
+
+// Strength reduction: an operator whose right operand (or left operand, for a product) is a constant is
+// replaced by a specialized instruction: x ^ 2 and x ^ 3 by products, x * 2^k by a shift, x / c by shifts or a
+// multiplication by a magic number (c other than 0, -1 and INT_MIN); x * 1 and x / 1 by x
+// Runs after the other passes, which do not read the specialized instructions
+void reduce_strength(t_ast *prog, t_opt_stats *stats);
+
+// Runs the optimization passes on the AST of a whole program, whose first statement can change
+// inputs: variables that do not start at 0 (propagate_constants())
+void optimize_program(t_ast **prog, t_arena *arena, uint64_t inputs, t_opt_stats *stats);
+
+// Returns the number of statements of the list, nested blocks included
+int count_statements(const t_ast *prog);
+
+// Returns a copy of the statement list, allocated in the arena, that the optimization passes of the original do
+// not change: the nodes and the code of the expressions are copied, the strings of the prints are shared
+t_ast *copy_ast(const t_ast *prog, t_arena *arena);
+
+// Prints what the optimization passes changed
+void print_opt_stats(FILE *file, const t_opt_stats *stats);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+
+#include "structures/prog_token_list.h"
+
+// Returns the tokens of the program s of size characters, lexed on nb_threads threads, identical to lex()
+// The source is split in chunks at lines starting in column 0, each chunk is lexed from the initial state
+// Chunks are joined in order: where the actual state differs, the start of the chunk is lexed again
+// until the two states meet. Small sources, or nb_threads <= 1, are lexed by lex()
+t_prog_token_list lex_parallel(const char *s, size_t size, t_arena *arena, int nb_threads);
+
+#endif
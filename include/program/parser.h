@@ -4,6 +4,48 @@
 #include "program.h"
 #include "structures/prog_token_list.h"
 
-t_ast *parse(const t_prog_token_list *token_list);
+// Kinds of statement lists
+typedef enum {
+    BLOCK_TOP, BLOCK_IF_TRUE, BLOCK_IF_FALSE, BLOCK_LOOP
+} e_block_type;
 
-#endif
\ No newline at end of file
+// Statement list being parsed, and the statement owning it (NULL for the top level)
+typedef struct {
+    e_block_type type;
+    t_ast *owner;
+    t_ast *head;
+    t_ast *tail;
+} t_parser_frame;
+
+// State of the parser: no global state, so several programs can be parsed at the same time
+typedef struct {
+    const t_prog_token_list *list;
+    unsigned int i;             // index of the next token
+    t_arena *arena;             // allocator of the AST nodes
+    bool is_else;               // the last statement list ended with an else
+    bool error;
+    t_parser_frame *frames;     // stack of the statement lists being parsed
+    int nb_frames;
+    int capacity;
+    t_ast *top_level;           // top-level statement list, set when the parsing is over
+} t_parser;
+
+t_parser create_parser(const t_prog_token_list *token_list, t_arena *arena);
+
+// Opens a statement list owned by owner (NULL for the top level)
+void push_parser_frame(t_parser *parser, e_block_type type, t_ast *owner);
+
+// Parses the statement at the current token, or ends the statement list on top of the stack
+// (at an end of block, an else, or the end of the tokens)
+// Returns false when the parsing is over: the top level was closed, or there was a syntax error
+bool parse_step(t_parser *parser);
+
+// Returns the AST of the tokens of the parser
+t_ast *parse_program(t_parser *parser);
+
+void destroy_parser(t_parser *parser);
+
+// Returns the AST of the program, its nodes are allocated in the arena
+t_ast *parse(const t_prog_token_list *token_list, t_arena *arena);
+
+#endif
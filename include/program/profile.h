@@ -0,0 +1,63 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "program/program.h"
+
+// Execution profile of one statement of the AST
+typedef struct {
+    const t_ast *node;
+    int parent;         // index of the statement whose block holds this one, -1 at the top level
+    uint64_t count;     // executions, a loop is executed once per evaluation of its condition
+    uint64_t taken;     // If, While, For: evaluations of the condition that were true
+    uint64_t evals;     // evaluations of its expressions
+    uint64_t ticks;     // time spent in the statement itself, its expressions included, its blocks excluded
+} t_node_profile;
+
+// Profile of one execution of a program by the AST walker
+// The time is read once per statement, in cycles of the time-stamp counter on x86-64, in nanoseconds elsewhere
+typedef struct {
+    t_node_profile *nodes;  // statements in the order of the program: index profile_id of the node
+    int nb_nodes;
+    int current;            // statement being executed, -1 before the first one
+    uint64_t last_tick;     // time when the current statement started
+    uint64_t total_ticks;
+} t_profile;
+
+// Instrumentation: when not NULL, run() counts and times every statement in this profile
+// Shared by all threads, only enabled for one program at a time
+extern t_profile *run_profile;
+
+// Unit of the ticks: "cycles" or "ns"
+extern const char *const profile_tick_unit;
+
+// Numbers the statements of prog (profile_id) and creates their empty profile
+void init_profile(t_profile *profile, t_ast *prog);
+
+// Starts the statement node: the time since the previous call goes to the previous statement
+// again: a loop that evaluates its condition after its block, and not when it is reached
+void profile_statement(t_profile *profile, const t_ast *node, bool again);
+
+// The condition of the current statement (If, While, For) was true
+void profile_taken(t_profile *profile, const t_ast *node);
+
+// Ends the execution: the time since the last statement started goes to it
+void finish_profile(t_profile *profile);
+
+// Prints the statements, the most expensive first: time spent in the statement, with its blocks, executions,
+// evaluations of expressions
+void print_profile_report(FILE *file, const t_profile *profile);
+
+// Executions of the statements of the list that reach the statement after the list
+uint64_t profile_list_exits(const t_profile *profile, const t_ast *list);
+
+// Writes the Mermaid graph of the program (print_ast()) in file_name, each statement coloured by its share of the
+// time and annotated with its executions, each edge with the number of times it was followed
+void print_ast_profile(const t_ast *prog, const t_profile *profile, const char *file_name);
+
+// Destructor
+void destroy_profile(t_profile *profile);
+
+#endif
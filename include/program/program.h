@@ -81,19 +81,34 @@ typedef union {
 // Recursive type for AST: a statement, its type, and a pointer to the next node of the AST
 typedef struct s_ast {
     e_statement_type command;
+    int profile_id;     // index of the statement in a profile (init_profile()), not set otherwise
     u_statement statement;
     struct s_ast *next;
 } t_ast;
 
+// Execution engines: the AST walker (reference), the bytecode VM, or native code generated by the JIT
+typedef enum {
+    ENGINE_AST, ENGINE_VM, ENGINE_JIT
+} e_engine;
+
+// Options of run_program
+typedef struct {
+    e_engine engine;
+    bool mem_stats;     // prints the memory used by the compilation on stderr
+    FILE *output;       // output of print and return, stdout if NULL
+    int lex_threads;    // threads of the lexer, 1 for the sequential lexer
+} t_run_options;
+
+// Prints the statement on one line, without its blocks
+void print_prog_node(FILE *file, const t_ast *prog);
+
 void print_ast(const t_ast *prog, const char *file_name);
 
 // Parses and executes the program in the string s
-void run_program(const char *s);
+// The tokens, expressions and AST nodes are allocated in one arena, released at the end
+void run_program(const char *s, const t_run_options *options);
 
 // Exports the ast of the code in a file prog.mmd
 void export_program_ast(const char *s, const char *source_file_name);
 
-// Destructor
-void destroy_ast(t_ast *prog);
-
 #endif
\ No newline at end of file
@@ -3,6 +3,11 @@
 
 #include "program/program.h"
 
-void run(t_ast *prog);
+// Executes the program, all variables start at 0, print and return write in out
+void run(const t_ast *prog, FILE *out);
+
+// Executes the statements from prog with the variables var_value (NB_SLOTS slots), which keep their values afterwards
+// Returns true if a return statement was reached
+bool run_statements(int var_value[], const t_ast *prog, FILE *out);
 
 #endif
\ No newline at end of file
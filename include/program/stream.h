@@ -0,0 +1,14 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "program/program.h"
+
+// Lexes, parses and executes the program read on fd, one top-level statement at a time
+// Each top-level statement runs as soon as it is complete, then its tokens and AST nodes are released:
+// the memory used does not depend on the length of the program, only on its largest top-level statement
+// The output is the same as run_program(), but a syntax error is found when its statement is reached,
+// after the output of the statements before it. Always runs on the AST walker
+// Returns false if fd could not be read
+bool run_stream(int fd, const t_run_options *options);
+
+#endif
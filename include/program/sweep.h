@@ -0,0 +1,31 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdint.h>
+
+#include "program/bytecode.h"
+
+// Starting values of the variables of one run of a sweep
+typedef struct {
+    int value[NB_VARIABLES];
+    uint64_t assigned;      // variables given by the environment (bit 1 << slot), the others start at 0
+} t_sweep_env;
+
+// Reads the environments of a sweep: one run per non-empty line, whose assignments "a=1 b=-2" are separated by
+// spaces or commas
+// Returns false, after printing the error, if the file cannot be read or a line is malformed
+bool load_sweep_envs(const char *file_name, t_sweep_env **envs, int *nb_envs);
+
+// Variables assigned by at least one environment: the inputs of the program (compile_program_inputs())
+uint64_t sweep_inputs(const t_sweep_env *envs, int nb_envs);
+
+// Runs the bytecode once per environment: the environments are grouped in lanes of SIMD vectors (AVX2 if the
+// processor has it, SSE otherwise, one lane without GCC vector extensions), run in lockstep on nb_threads threads
+// A lane that leaves the others at a branch is masked until they meet again: each run behaves as run_vm()
+// A division by zero stops its run only
+// The outputs are written on stdout in the order of the environments, preceded by "==> a=1 b=-2 <==", then a
+// summary on stderr
+// Returns the number of runs that failed
+int run_sweep(const t_bytecode *bc, const t_sweep_env *envs, int nb_envs, int nb_threads);
+
+#endif
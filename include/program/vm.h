@@ -0,0 +1,9 @@
+#ifndef VM_H
+#define VM_H
+
+#include "program/bytecode.h"
+
+// Executes the bytecode, all variables start at 0, print and return write in out
+void run_vm(const t_bytecode *bc, FILE *out);
+
+#endif
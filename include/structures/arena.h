@@ -0,0 +1,44 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Block of memory owned by an arena
+typedef struct s_arena_block {
+    struct s_arena_block *next;
+    size_t capacity;
+    size_t used;
+    max_align_t data[];
+} t_arena_block;
+
+// Bump allocator: everything allocated in the arena is released at once
+typedef struct {
+    t_arena_block *head;    // block currently used for allocations
+    size_t bytes_used;      // bytes currently allocated
+    size_t peak_bytes_used; // maximum of bytes_used since the creation of the arena
+    size_t bytes_reserved;  // total size of the blocks
+} t_arena;
+
+t_arena create_arena();
+
+// Returns a block of size bytes, aligned for any type, owned by the arena
+void *arena_alloc(t_arena *arena, size_t size);
+
+// Returns a copy of the first length characters of s, NUL-terminated, owned by the arena
+char *arena_strndup(t_arena *arena, const char *s, size_t length);
+
+// Moves the blocks of other into the arena: what was allocated in other is now owned by the arena
+// other is left empty
+void arena_merge(t_arena *arena, t_arena *other);
+
+// Releases everything allocated in the arena, keeps the first block for reuse
+void arena_reset(t_arena *arena);
+
+// Prints the memory usage of the arena
+void print_arena_stats(FILE *file, const t_arena *arena);
+
+// Destructor: releases every block at once
+void destroy_arena(t_arena *arena);
+
+#endif
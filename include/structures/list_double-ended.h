@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include "expressions/expr_token.h"
+#include "structures/arena.h"
 
 typedef t_expr_token T;
 
@@ -16,12 +17,16 @@ typedef struct {
     t_cell *tail;
     int size;
     int num;
+    t_arena *arena; // allocator of the cells, NULL if they are allocated with malloc
 } t_list;
 
 /////
 
 t_list create_empty_list();
 
+// Returns an empty list whose cells are allocated in the arena (and released with it)
+t_list create_empty_arena_list(t_arena *arena);
+
 int length(const t_list *list);
 
 T get(const t_list *list, int index);
@@ -0,0 +1,29 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <pthread.h>
+
+// Tasks of a thread: indices front .. back-1, not started yet
+// The owner takes its tasks from the front, the other threads steal from the back
+typedef struct {
+    pthread_mutex_t lock;
+    int front;
+    int back;
+} t_task_deque;
+
+// Work-stealing pool running the tasks 0 .. nb_tasks-1
+typedef struct {
+    t_task_deque *deques;   // one deque per thread
+    int nb_threads;
+    void (*task)(void *arg, int index);
+    void *arg;
+} t_task_pool;
+
+// Runs task(arg, i) for every i in 0 .. nb_tasks-1 on nb_threads threads (the calling thread is one of them)
+// The tasks are split evenly between the deques, a thread whose deque is empty steals from the others
+void run_parallel_tasks(int nb_tasks, int nb_threads, void (*task)(void *arg, int index), void *arg);
+
+// Returns the number of cores available to the process
+int nb_available_cores();
+
+#endif
@@ -0,0 +1,229 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench/generator.h"
+#include "file_io/file.h"
+#include "program/compilation.h"
+#include "program/parallel_lexer.h"
+#include "program/parser.h"
+
+// Phases of the compilation and the execution of a program, timed separately
+typedef enum {
+    PHASE_READ_FILE, PHASE_LEX, PHASE_PARSE, PHASE_OPTIMIZE, PHASE_RUN, NB_PHASES
+} e_phase;
+
+const char *const phase_names[NB_PHASES] = { "read_file", "lex", "parse", "optimize", "run" };
+
+// Measures of one program: the fastest of its repetitions, for each phase
+typedef struct {
+    e_program_shape shape;
+    size_t size;            // size asked to the generator
+    size_t length;          // size of the program generated
+    int tokens;
+    int statements;         // statements of the parsed program, nested blocks included, before the optimizer
+    int repeats;
+    double ns[NB_PHASES];
+} t_bench_point;
+
+// Repetitions of a program: at least BENCH_MIN_REPEATS if it is small, then until BENCH_BUDGET_NS is spent
+#define BENCH_MIN_REPEATS 3
+#define BENCH_MAX_REPEATS 100
+#define BENCH_BUDGET_NS 5e8
+#define BENCH_SMALL_SIZE (1 << 20)
+
+double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+// Compiles and runs the program of the file once, phase by phase, as compile_program() and
+// run_compiled_program() do
+void bench_program(const char *file_name, const t_run_options *options, t_bench_point *point, double ns[]) {
+    struct timespec start[NB_PHASES], end[NB_PHASES];
+    t_source source;
+    clock_gettime(CLOCK_MONOTONIC, &start[PHASE_READ_FILE]);
+    if (!load_source(file_name, &source))
+        exit(EXIT_FAILURE);
+    clock_gettime(CLOCK_MONOTONIC, &end[PHASE_READ_FILE]);
+
+    t_program *program = malloc(sizeof(t_program));
+    *program = (t_program) { .arena = create_arena() };
+    clock_gettime(CLOCK_MONOTONIC, &start[PHASE_LEX]);
+    t_prog_token_list list = lex_parallel(source.data, source.size, &program->arena, options->lex_threads);
+    clock_gettime(CLOCK_MONOTONIC, &end[PHASE_LEX]);
+    start[PHASE_PARSE] = end[PHASE_LEX];
+    program->ast = parse(&list, &program->arena);
+    clock_gettime(CLOCK_MONOTONIC, &end[PHASE_PARSE]);
+    point->tokens = list.size;
+    point->statements = count_statements(program->ast);
+    ptl_destroy_list(&list);
+
+    clock_gettime(CLOCK_MONOTONIC, &start[PHASE_OPTIMIZE]);
+    optimize_program(&program->ast, &program->arena, 0, &program->opt_stats);
+    clock_gettime(CLOCK_MONOTONIC, &end[PHASE_OPTIMIZE]);
+    start[PHASE_RUN] = end[PHASE_OPTIMIZE];
+    run_compiled_program(program, options);
+    clock_gettime(CLOCK_MONOTONIC, &end[PHASE_RUN]);
+
+    destroy_program(program);
+    release_source(&source);
+    for (int phase = 0; phase < NB_PHASES; phase++)
+        ns[phase] = elapsed_ns(&start[phase], &end[phase]);
+}
+
+// Generates the program of the point in a temporary file, then compiles and runs it until the measures are stable
+void bench_point(t_bench_point *point, const uint64_t seed, const t_run_options *options) {
+    char file_name[] = "/tmp/compiler_bench_XXXXXX";
+    const int fd = mkstemp(file_name);
+    if (fd < 0) {
+        fprintf(stderr, "Error: cannot create a temporary file (%s)\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    char *program = generate_program(point->shape, point->size, seed, &point->length);
+    FILE *file = fdopen(fd, "w");
+    fwrite(program, 1, point->length, file);
+    fclose(file);
+    free(program);
+
+    double total = 0;
+    for (int phase = 0; phase < NB_PHASES; phase++)
+        point->ns[phase] = 0;
+    point->repeats = 0;
+    const int min_repeats = point->size <= BENCH_SMALL_SIZE ? BENCH_MIN_REPEATS : 1;
+    while (point->repeats < BENCH_MAX_REPEATS && (point->repeats < min_repeats || total < BENCH_BUDGET_NS)) {
+        double ns[NB_PHASES];
+        bench_program(file_name, options, point, ns);
+        for (int phase = 0; phase < NB_PHASES; phase++) {
+            if (point->repeats == 0 || ns[phase] < point->ns[phase])
+                point->ns[phase] = ns[phase];
+            total += ns[phase];
+        }
+        point->repeats++;
+    }
+    unlink(file_name);
+}
+
+void print_json_phases(FILE *file, const char *name, const t_bench_point *point, const double divisor) {
+    fprintf(file, "\"%s\": {", name);
+    for (int phase = 0; phase < NB_PHASES; phase++)
+        fprintf(file, "%s\"%s\": %.3f", phase == 0 ? "" : ", ", phase_names[phase], point->ns[phase] / divisor);
+    fprintf(file, "}");
+}
+
+void print_json_point(FILE *file, const t_bench_point *point, const bool last) {
+    fprintf(file, "    {\"shape\": \"%s\", \"size\": %zu, \"bytes\": %zu, \"tokens\": %d, \"statements\": %d, "
+                  "\"repeats\": %d,\n     ", program_shape_names[point->shape], point->size, point->length,
+            point->tokens, point->statements, point->repeats);
+    print_json_phases(file, "ns", point, 1);
+    fprintf(file, ",\n     ");
+    print_json_phases(file, "ns_per_token", point, point->tokens);
+    fprintf(file, ",\n     ");
+    print_json_phases(file, "ns_per_statement", point, point->statements);
+    fprintf(file, "}%s\n", last ? "" : ",");
+}
+
+// Size with an optional suffix K or M (powers of 1024), 0 if malformed
+size_t parse_size(const char *s) {
+    char *end;
+    const long long size = strtoll(s, &end, 10);
+    size_t unit = 1;
+    if (*end == 'K' || *end == 'M')
+        unit = *end++ == 'K' ? 1 << 10 : 1 << 20;
+    return size > 0 && *end == '\0' ? size * unit : 0;
+}
+
+void usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s [--min-size=1K] [--max-size=100M] [--shape=straight|expressions|loops|nested]... "
+                    "[--engine=ast|vm|jit] [--lex-jobs=N] [--seed=N] [--output=bench.json]\n", prog_name);
+}
+
+int main(int argc, char **argv) {
+    size_t min_size = 1 << 10;
+    size_t max_size = 100 << 20;
+    bool shapes[NB_PROGRAM_SHAPES] = { false };
+    bool all_shapes = true;
+    uint64_t seed = 1;
+    const char *output_name = NULL;
+    // One lexer thread by default: the cost per token does not depend on the machine
+    t_run_options options = { .engine = ENGINE_AST, .mem_stats = false, .output = NULL, .lex_threads = 1 };
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--min-size=", 11) == 0 && parse_size(argv[i] + 11) > 0) {
+            min_size = parse_size(argv[i] + 11);
+        } else if (strncmp(argv[i], "--max-size=", 11) == 0 && parse_size(argv[i] + 11) > 0) {
+            max_size = parse_size(argv[i] + 11);
+        } else if (strncmp(argv[i], "--shape=", 8) == 0
+                   && find_program_shape(argv[i] + 8) != NB_PROGRAM_SHAPES) {
+            shapes[find_program_shape(argv[i] + 8)] = true;
+            all_shapes = false;
+        } else if (strcmp(argv[i], "--engine=ast") == 0) {
+            options.engine = ENGINE_AST;
+        } else if (strcmp(argv[i], "--engine=vm") == 0) {
+            options.engine = ENGINE_VM;
+        } else if (strcmp(argv[i], "--engine=jit") == 0) {
+            options.engine = ENGINE_JIT;
+        } else if (strncmp(argv[i], "--lex-jobs=", 11) == 0 && atoi(argv[i] + 11) > 0) {
+            options.lex_threads = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = strtoull(argv[i] + 7, NULL, 10);
+        } else if (strncmp(argv[i], "--output=", 9) == 0 && argv[i][9] != '\0') {
+            output_name = argv[i] + 9;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The output of the programs is discarded, its cost is part of the run
+    options.output = fopen("/dev/null", "w");
+    FILE *json = output_name != NULL ? fopen(output_name, "w") : stdout;
+    if (options.output == NULL || json == NULL) {
+        fprintf(stderr, "Error: cannot open file %s (%s)\n", output_name != NULL ? output_name : "/dev/null",
+                strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    static const char *const engine_names[] = { "ast", "vm", "jit" };
+#ifdef __OPTIMIZE__
+    const bool optimized = true;
+#else
+    const bool optimized = false;
+#endif
+    fprintf(json, "{\n  \"optimized\": %s,\n  \"engine\": \"%s\",\n  \"lex_threads\": %d,\n  \"seed\": %llu,\n"
+                  "  \"points\": [\n", optimized ? "true" : "false", engine_names[options.engine],
+            options.lex_threads, (unsigned long long) seed);
+    if (!optimized)
+        fprintf(stderr, "Warning: the benchmark is not compiled with optimizations\n");
+
+    // Sizes from min_size to max_size, by factors of 10
+    int nb_sizes = 0;
+    for (size_t size = min_size; size <= max_size; size *= 10)
+        nb_sizes++;
+    int nb_points = 0;
+    int total_points = 0;
+    for (int shape = 0; shape < NB_PROGRAM_SHAPES; shape++)
+        total_points += all_shapes || shapes[shape] ? nb_sizes : 0;
+    for (int shape = 0; shape < NB_PROGRAM_SHAPES; shape++) {
+        if (!all_shapes && !shapes[shape])
+            continue;
+        for (size_t size = min_size; size <= max_size; size *= 10) {
+            t_bench_point point = { .shape = shape, .size = size };
+            bench_point(&point, seed, &options);
+            print_json_point(json, &point, ++nb_points == total_points);
+            fflush(json);
+            fprintf(stderr, "%-12s %10zu bytes %10d tokens %9d statements, ns/token:", program_shape_names[shape],
+                    point.length, point.tokens, point.statements);
+            for (int phase = 0; phase < NB_PHASES; phase++)
+                fprintf(stderr, " %s %.2f", phase_names[phase], point.ns[phase] / point.tokens);
+            fprintf(stderr, "\n");
+        }
+    }
+    fprintf(json, "  ]\n}\n");
+
+    if (json != stdout)
+        fclose(json);
+    fclose(options.output);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench/generator.h"
+
+const char *const program_shape_names[NB_PROGRAM_SHAPES] = { "straight", "expressions", "loops", "nested" };
+
+// Variables of the generated statements, the loops count with i and j, z is the seed of the prelude
+#define NB_GEN_VARIABLES 8
+// Deepest block of the nested shape
+#define NESTED_DEPTH 32
+
+// Program being generated
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    uint64_t state;     // pseudo-random generator (xorshift64*)
+} t_generator;
+
+e_program_shape find_program_shape(const char *name) {
+    for (int shape = 0; shape < NB_PROGRAM_SHAPES; shape++) {
+        if (strcmp(program_shape_names[shape], name) == 0)
+            return shape;
+    }
+    return NB_PROGRAM_SHAPES;
+}
+
+// Returns a pseudo-random number in [0, n)
+int gen_random(t_generator *gen, const int n) {
+    gen->state ^= gen->state >> 12;
+    gen->state ^= gen->state << 25;
+    gen->state ^= gen->state >> 27;
+    return (int) ((gen->state * 2685821657736338717ull >> 33) % n);
+}
+
+char gen_variable(t_generator *gen) {
+    return (char) ('a' + gen_random(gen, NB_GEN_VARIABLES));
+}
+
+void gen_append(t_generator *gen, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    const int n = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (gen->length + n + 1 > gen->capacity) {
+        while (gen->length + n + 1 > gen->capacity)
+            gen->capacity *= 2;
+        gen->data = realloc(gen->data, gen->capacity);
+    }
+    vsnprintf(gen->data + gen->length, n + 1, format, args);
+    gen->length += n;
+    va_end(args);
+}
+
+void gen_indent(t_generator *gen, const int depth) {
+    gen_append(gen, "%*s", 4 * depth, "");
+}
+
+// Expression of the given depth: a division or a product has a constant operand, so no division by zero
+// A product follows a division by a larger constant: the expression is at most 2^depth times its largest operand
+void gen_expression(t_generator *gen, const int depth) {
+    if (depth == 0) {
+        if (gen_random(gen, 4) == 0)
+            gen_append(gen, "%d", 1 + gen_random(gen, 99));
+        else
+            gen_append(gen, "%c", gen_variable(gen));
+        return;
+    }
+    static const char *const operators[] = { "+", "-", "+", "-", "<", "==", "&", "|" };
+    gen_append(gen, "(");
+    switch (gen_random(gen, 5)) {
+        case 0:
+            gen_expression(gen, depth - 1);
+            gen_append(gen, " / %d", 2 + gen_random(gen, 8));
+            break;
+        case 1: {
+            const int divisor = 2 + gen_random(gen, 4);
+            gen_expression(gen, depth - 1);
+            gen_append(gen, " / %d * %d", divisor, 2 + gen_random(gen, divisor - 1));
+            break;
+        }
+        default:
+            gen_expression(gen, depth - 1);
+            gen_append(gen, " %s ", operators[gen_random(gen, sizeof(operators) / sizeof(operators[0]))]);
+            gen_expression(gen, depth - 1);
+            break;
+    }
+    gen_append(gen, ")");
+}
+
+// The value is divided by 2^depth, so the variables stay bounded: an overflow is undefined behaviour in the engines
+void gen_assignment(t_generator *gen, const int indent, const int depth) {
+    gen_indent(gen, indent);
+    gen_append(gen, "%c = ", gen_variable(gen));
+    gen_expression(gen, depth);
+    gen_append(gen, " / %d\n", 1 << depth);
+}
+
+// Sixteen short assignments and a print
+void gen_straight(t_generator *gen) {
+    for (int i = 0; i < 16; i++)
+        gen_assignment(gen, 0, 1 + gen_random(gen, 2));
+    gen_append(gen, "print %c\n", gen_variable(gen));
+}
+
+void gen_expressions(t_generator *gen) {
+    gen_assignment(gen, 0, 6);
+}
+
+// A for loop then a while loop, whose bodies divide: the optimizer cannot replace them by their closed form
+void gen_loops(t_generator *gen) {
+    const int iterations = 20 + gen_random(gen, 30);
+    char v = gen_variable(gen);
+    gen_append(gen, "for (i = 0; i < %d; i + 1)\n", iterations);
+    gen_append(gen, "    %c = %c / 2 + i\n", v, v);
+    gen_assignment(gen, 1, 1);
+    v = gen_variable(gen);
+    gen_append(gen, "j = 0\n");
+    gen_append(gen, "while (j < %d)\n", iterations);
+    gen_append(gen, "    %c = (%c + j) / %d\n", v, v, 2 + gen_random(gen, 8));
+    gen_append(gen, "    j = j + 1\n");
+}
+
+// A chain of if blocks nested NESTED_DEPTH deep, each with an else
+void gen_nested(t_generator *gen, const int depth) {
+    gen_indent(gen, depth);
+    gen_append(gen, "if (%c < %d)\n", gen_variable(gen), 10 + gen_random(gen, 90));
+    gen_assignment(gen, depth + 1, 1);
+    if (depth + 1 < NESTED_DEPTH)
+        gen_nested(gen, depth + 1);
+    gen_indent(gen, depth);
+    gen_append(gen, "else\n");
+    gen_assignment(gen, depth + 1, 1);
+}
+
+char *generate_program(const e_program_shape shape, const size_t size, const uint64_t seed, size_t *length) {
+    t_generator gen = { .data = malloc(4096), .length = 0, .capacity = 4096, .state = seed * 2 + 1 };
+    // Prelude: z is only known after a loop that is neither counted nor polynomial, the variables derive from it
+    gen_append(&gen, "z = 1\nwhile (z < 1000000)\n    z = z * 3 + 1\n");
+    for (int i = 0; i < NB_GEN_VARIABLES; i++)
+        gen_append(&gen, "%c = z / %d - %d\n", 'a' + i, 3 + i, 1000 * i);
+    do {
+        switch (shape) {
+            case PROGRAM_STRAIGHT:
+                gen_straight(&gen);
+                break;
+            case PROGRAM_EXPRESSIONS:
+                gen_expressions(&gen);
+                break;
+            case PROGRAM_LOOPS:
+                gen_loops(&gen);
+                break;
+            default:
+                gen_nested(&gen, 0);
+                break;
+        }
+    } while (gen.length < size);
+    gen_append(&gen, "return a\n");
+    *length = gen.length;
+    return gen.data;
+}
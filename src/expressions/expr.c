@@ -1,8 +1,8 @@
 #include "expressions/expr.h"
 #include "structures/stack.h"
+#include "program/error.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
 // Returns true if the expression has no token left
 bool is_empty_expr(const t_expr *expr) {
@@ -10,14 +10,12 @@ bool is_empty_expr(const t_expr *expr) {
 }
 
 bool is_constant_expr_rpn(const t_expr_rpn *expr_rpn) {
-    if (is_empty_expr(&expr_rpn->expr)) {
-        fprintf(stderr, "is_constant_expr_rpn: empty expression");
-        exit(EXIT_FAILURE);
+    if (expr_rpn->size == 0) {
+        fprintf(error_stream(), "is_constant_expr_rpn: empty expression");
+        program_error();
     }
-    t_expr expr = expr_rpn->expr;
-    while (!is_empty_expr(&expr)) {
-        const t_expr_token token = get_next_token(&expr);
-        if (token.type == VARIABLE) {
+    for (int i = 0; i < expr_rpn->size; i++) {
+        if (expr_rpn->code[i].opcode == RPN_VAR) {
             return false;
         }
     }
@@ -46,6 +44,60 @@ void print_expr_file(FILE *file, const t_expr *expr) {
     print_list_file(file, &expr->list);
 }
 
+void print_variable_file(FILE *file, const int slot) {
+    if (slot < NB_VARIABLES)
+        fprintf(file, "%c", 'a' + slot);
+    else
+        fprintf(file, "t%d", slot - NB_VARIABLES);
+}
+
+void print_rpn_instr_file(FILE *file, const t_rpn_instr *instr) {
+    switch (instr->opcode) {
+        case RPN_CONST:
+            fprintf(file, "%d", instr->arg.val);
+            break;
+        case RPN_VAR:
+            print_variable_file(file, instr->arg.slot);
+            break;
+        case RPN_OP:
+            print_operator_file(file, instr->arg.op);
+            break;
+        // The specialized instructions are written as the constant operand and the operator they replace
+        case RPN_SQUARE:
+            fprintf(file, "2 ^");
+            break;
+        case RPN_CUBE:
+            fprintf(file, "3 ^");
+            break;
+        case RPN_SHL:
+            fprintf(file, "%u *", 1u << instr->arg.shift);
+            break;
+        case RPN_DIV_CONST:
+            fprintf(file, "%d /", instr->arg.div.divisor);
+            break;
+        // The jumps are not written: the expression reads as the operators they belong to
+        case RPN_AND_JUMP:
+        case RPN_OR_JUMP:
+            break;
+    }
+}
+
+void print_expr_rpn(const t_expr_rpn *expr_rpn) {
+    print_expr_rpn_file(stdout, expr_rpn);
+}
+
+void print_expr_rpn_file(FILE *file, const t_expr_rpn *expr_rpn) {
+    bool first = true;
+    for (int i = 0; i < expr_rpn->size; i++) {
+        const t_rpn_instr *instr = &expr_rpn->code[i];
+        if (instr->opcode == RPN_AND_JUMP || instr->opcode == RPN_OR_JUMP)
+            continue;
+        if (!first) fprintf(file, " ");
+        print_rpn_instr_file(file, instr);
+        first = false;
+    }
+}
+
 // Returns the int at the beginning of the string pointed at by p_s
 // Moves p_s past the int
 int parse_int(const char **p_s) {
@@ -61,29 +113,27 @@ int parse_int(const char **p_s) {
     return n;
 }
 
-char* parse_string(const char **p_s) {
+char* parse_string(const char **p_s, t_arena *arena) {
     const char *s = *p_s;
     int len = 0;
     s++;
     while (s[len] != '"') {
         if (s[len] == '\0') {
-            fprintf(stderr, "parse_expr: Syntax error, malformed expression (EOF)");
+            fprintf(error_stream(), "parse_expr: Syntax error, malformed expression (EOF)");
         }
         len++;
     }
-    char* string = malloc(sizeof(char)*len+1);
-    memcpy(string, s, sizeof(char)*len);
-    string[len] = '\0';
+    char* string = arena_strndup(arena, s, len);
     for (int i = 0; i < len; i++) s++;
     *p_s = s + 1;
     return string;
 }
 
 // Converts the string s to an expression of type t_expr
-t_expr parse_expr(const char **s) {
+t_expr parse_expr(const char **s, t_arena *arena) {
 
     t_expr expr;
-    expr.list = create_empty_list();
+    expr.list = create_empty_arena_list(arena);
 
     const char *p = *s;
 
@@ -97,7 +147,7 @@ t_expr parse_expr(const char **s) {
 
         t_expr_token token;
         if (*p == '"') {
-            char* string = parse_string(&p);
+            char* string = parse_string(&p, arena);
             token = token_of_string(string);
         } else if (*p >= 'a' && *p <= 'z') { // var
             token = token_of_variable(*p);
@@ -117,8 +167,8 @@ t_expr parse_expr(const char **s) {
                 parsed_number = true;
             }
             else {
-                printf("parse_expr: wrong syntax (\"%s\")\n", p);
-                exit(EXIT_FAILURE);
+                fprintf(error_stream(), "parse_expr: wrong syntax (\"%s\")\n", p);
+                program_error();
             }
         }
         // Operator
@@ -165,122 +215,311 @@ t_expr parse_expr(const char **s) {
     return expr;
 }
 
+t_div_const div_const_of(const int divisor) {
+    t_div_const div = {divisor, 0, 0};
+    const unsigned abs_d = divisor < 0 ? -(unsigned) divisor : (unsigned) divisor;
+    if ((abs_d & (abs_d - 1)) == 0) {
+        while ((1u << div.shift) != abs_d)
+            div.shift++;
+        return div;
+    }
+
+    // Smallest p >= 32 such that 2^p > nc * (abs_d - 2^p % abs_d), nc being the largest multiple of abs_d
+    // minus 1 that fits; the magic number is then (2^p + abs_d - 2^p % abs_d) / abs_d
+    const unsigned two31 = 0x80000000u;
+    const unsigned t = two31 + ((unsigned) divisor >> 31);
+    const unsigned anc = t - 1 - t % abs_d;
+    unsigned q1 = two31 / anc, r1 = two31 - q1 * anc;
+    unsigned q2 = two31 / abs_d, r2 = two31 - q2 * abs_d;
+    unsigned delta;
+    int p = 31;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= abs_d) {
+            q2++;
+            r2 -= abs_d;
+        }
+        delta = abs_d - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    div.magic = (int) (divisor < 0 ? -(q2 + 1) : q2 + 1);
+    div.shift = p - 32;
+    return div;
+}
+
+int apply_div_const(const t_div_const *div, const int a) {
+    if (div->magic == 0) {
+        // Negative dividends are biased by 2^shift - 1 so that the shift rounds toward zero
+        const int bias = (a >> 31) & (int) ((1u << div->shift) - 1);
+        const int q = (a + bias) >> div->shift;
+        return div->divisor < 0 ? -q : q;
+    }
+    int q = (int) (((long long) div->magic * a) >> 32);
+    if (div->divisor > 0 && div->magic < 0)
+        q = (int) ((unsigned) q + (unsigned) a);
+    else if (div->divisor < 0 && div->magic > 0)
+        q = (int) ((unsigned) q - (unsigned) a);
+    q >>= div->shift;
+    return q + (int) ((unsigned) q >> 31);
+}
+
 void error_rpn() {
-    printf("Error: expression is not in Reverse Polish notation\n");
-    exit(EXIT_FAILURE);
+    fprintf(error_stream(), "Error: expression is not in Reverse Polish notation\n");
+    program_error();
 }
 
 
 ////////////////////////////////////////////////////////////////////
 
-// Returns the value of the variable var
-int look_up_variable(const int var_table[], const char var) {
-    return var_table[(unsigned char)var - 'a'];
+// Returns the superinstruction of the expression, SUPER_GENERIC if it has none
+// A division by a constant 0 stays generic: apply_op() reports it
+int rpn_superinstruction(const t_expr_rpn *expr_rpn) {
+    const t_rpn_instr *code = expr_rpn->code;
+    if (expr_rpn->size == 1 && code[0].opcode == RPN_CONST)
+        return SUPER_ID(SHAPE_CONST, 0);
+    if (expr_rpn->size == 1 && code[0].opcode == RPN_VAR)
+        return SUPER_ID(SHAPE_VAR, 0);
+    if (expr_rpn->size == 2 && code[0].opcode == RPN_VAR && code[1].opcode >= RPN_SQUARE)
+        return SUPER_ID(SHAPE_VAR_SPECIAL, code[1].opcode - RPN_SQUARE);
+    if (expr_rpn->size != 3 || code[2].opcode != RPN_OP || code[2].arg.op == NOT)
+        return SUPER_GENERIC;
+
+    const operator_type op = code[2].arg.op;
+    if (code[0].opcode == RPN_VAR && code[1].opcode == RPN_CONST)
+        return op == DIV && code[1].arg.val == 0 ? SUPER_GENERIC : SUPER_ID(SHAPE_VAR_OP_CONST, op);
+    if (code[0].opcode == RPN_VAR && code[1].opcode == RPN_VAR)
+        return SUPER_ID(SHAPE_VAR_OP_VAR, op);
+    if (code[0].opcode == RPN_CONST && code[1].opcode == RPN_VAR)
+        return SUPER_ID(SHAPE_CONST_OP_VAR, op);
+    return SUPER_GENERIC;
 }
 
-// Returns the value of the token t (of type NUMBER or VARIABLE)
-int get_value(const int var_table[], const t_expr_token *t) {
-    if (t == NULL) {
-        fprintf(stderr, "get_value: null token\n");
-        exit(EXIT_FAILURE);
+// Computes the skips of the jumps of the expression: the operator of a jump is the first binary operator after it
+// that leaves the stack as deep as the jump found it (it consumes the left operand the jump tests)
+// A jump that does not match an operator of its kind skips nothing
+#define JUMPS_LOCAL_SIZE 64
+void update_jumps_rpn(t_expr_rpn *expr_rpn) {
+    t_rpn_instr *code = expr_rpn->code;
+    const int n = expr_rpn->size;
+    int local[2 * JUMPS_LOCAL_SIZE];
+    int *pending = n <= JUMPS_LOCAL_SIZE ? local : malloc(2 * n * sizeof(int)); // jumps waiting, innermost last
+    int *depths = pending + n;                                                  // depth of the stack at each one
+    int nb_pending = 0;
+    int depth = 0;
+    for (int i = 0; i < n; i++) {
+        const t_rpn_instr *instr = &code[i];
+        if (instr->opcode == RPN_CONST || instr->opcode == RPN_VAR) {
+            depth++;
+        } else if (instr->opcode == RPN_AND_JUMP || instr->opcode == RPN_OR_JUMP) {
+            code[i].arg.skip = 0;
+            pending[nb_pending] = i;
+            depths[nb_pending++] = depth;
+        } else if (instr->opcode == RPN_OP && instr->arg.op != NOT) {
+            depth--;
+            while (nb_pending > 0 && depths[nb_pending - 1] >= depth) {
+                const int j = pending[--nb_pending];
+                const operator_type op = code[j].opcode == RPN_AND_JUMP ? AND : OR;
+                if (depths[nb_pending] == depth && instr->arg.op == op)
+                    code[j].arg.skip = i - j;
+            }
+        }
     }
+    if (pending != local)
+        free(pending);
+}
 
-    switch (t->type) {
-        case NUMBER: {
-            return t->content.val;
-        }
-        case VARIABLE: {
-            return look_up_variable(var_table, t->content.var);
-        }
-        default:
-            fprintf(stderr, "get_value: unexpected token type\n");
-            exit(EXIT_FAILURE);
+void update_max_depth_rpn(t_expr_rpn *expr_rpn) {
+    int depth = 0;
+    bool has_jumps = false;
+    expr_rpn->max_depth = 0;
+    for (int i = 0; i < expr_rpn->size; i++) {
+        const t_rpn_instr *instr = &expr_rpn->code[i];
+        if (instr->opcode == RPN_CONST || instr->opcode == RPN_VAR)
+            depth++;
+        else if (instr->opcode == RPN_OP && instr->arg.op != NOT)
+            depth--;
+        else if (instr->opcode == RPN_AND_JUMP || instr->opcode == RPN_OR_JUMP)
+            has_jumps = true;
+        if (depth > expr_rpn->max_depth)
+            expr_rpn->max_depth = depth;
     }
+    if (has_jumps)
+        update_jumps_rpn(expr_rpn);
+    expr_rpn->super = rpn_superinstruction(expr_rpn);
 }
 
+// Fused code of the superinstructions of one binary shape: a and b are read without the value stack,
+// the operator is known at compile time
+#define SUPER_BINARY_CASES(shape, A, B)                                                         \
+    case SUPER_ID(shape, ADD):      { const int a = (A); const int b = (B); return a + b; }      \
+    case SUPER_ID(shape, SUB):      { const int a = (A); const int b = (B); return a - b; }      \
+    case SUPER_ID(shape, MULT):     { const int a = (A); const int b = (B); return a * b; }      \
+    case SUPER_ID(shape, DIV):      { const int a = (A); const int b = (B);                     \
+                                      return b != 0 ? a / b : apply_op(DIV, a, b); }            \
+    case SUPER_ID(shape, EXP):      { const int a = (A); const int b = (B); return fast_exp(a, b); } \
+    case SUPER_ID(shape, EQUAL):    { const int a = (A); const int b = (B); return a == b; }     \
+    case SUPER_ID(shape, DIFF):     { const int a = (A); const int b = (B); return a != b; }     \
+    case SUPER_ID(shape, LESS):     { const int a = (A); const int b = (B); return a < b; }      \
+    case SUPER_ID(shape, GREATER):  { const int a = (A); const int b = (B); return a > b; }      \
+    case SUPER_ID(shape, LEQ):      { const int a = (A); const int b = (B); return a <= b; }     \
+    case SUPER_ID(shape, GEQ):      { const int a = (A); const int b = (B); return a >= b; }     \
+    case SUPER_ID(shape, AND):      { const int a = (A); const int b = (B); return a && b; }     \
+    case SUPER_ID(shape, OR):       { const int a = (A); const int b = (B); return a || b; }     \
+    case SUPER_ID(shape, XOR):      { const int a = (A); const int b = (B); return (a != 0) != (b != 0); }
+
 // TODO create an eval string function, split eval rpn and eval string
 // Returns the result of the evaluation of the expression expr, in Reverse Polish notation
 int eval_rpn(const int var_table[], const t_expr_rpn *expr_rpn) {
 
-    t_list list_copy = expr_rpn->expr.list;
-    t_expr expr = { .list = list_copy };
+    if (super_stats_enabled)
+        super_hits[expr_rpn->super]++;
+    const t_rpn_instr *code = expr_rpn->code;
+    switch (expr_rpn->super) {
+        case SUPER_ID(SHAPE_CONST, 0):
+            return code[0].arg.val;
+        case SUPER_ID(SHAPE_VAR, 0):
+            return var_table[code[0].arg.slot];
+        SUPER_BINARY_CASES(SHAPE_VAR_OP_CONST, var_table[code[0].arg.slot], code[1].arg.val)
+        SUPER_BINARY_CASES(SHAPE_VAR_OP_VAR, var_table[code[0].arg.slot], var_table[code[1].arg.slot])
+        SUPER_BINARY_CASES(SHAPE_CONST_OP_VAR, code[0].arg.val, var_table[code[1].arg.slot])
+        case SUPER_ID(SHAPE_VAR_SPECIAL, RPN_SQUARE - RPN_SQUARE): {
+            const int a = var_table[code[0].arg.slot];
+            return a * a;
+        }
+        case SUPER_ID(SHAPE_VAR_SPECIAL, RPN_CUBE - RPN_SQUARE): {
+            const int a = var_table[code[0].arg.slot];
+            return a * a * a;
+        }
+        case SUPER_ID(SHAPE_VAR_SPECIAL, RPN_SHL - RPN_SQUARE):
+            return (int) ((unsigned) var_table[code[0].arg.slot] << code[1].arg.shift);
+        case SUPER_ID(SHAPE_VAR_SPECIAL, RPN_DIV_CONST - RPN_SQUARE):
+            return apply_div_const(&code[1].arg.div, var_table[code[0].arg.slot]);
+        default:
+            break;
+    }
 
-    t_stack stack = create_empty_stack();
+    int stack[expr_rpn->max_depth > 0 ? expr_rpn->max_depth : 1];
+    int size = 0;
 
-    while (!is_empty_expr(&expr)) {
-        const t_expr_token token = get_next_token(&expr);
+    for (int i = 0; i < expr_rpn->size; i++) {
+        const t_rpn_instr *instr = &expr_rpn->code[i];
 
-        switch (token.type) {
-            case NUMBER:
-            case VARIABLE:
-                push(&stack, token);
+        switch (instr->opcode) {
+            case RPN_CONST:
+                stack[size++] = instr->arg.val;
+                break;
+            case RPN_VAR:
+                stack[size++] = var_table[instr->arg.slot];
                 break;
-            
-            case OPERATOR: {
-                if (token.content.op == NOT) {
-                    if (stack.list.size < 1) {
-                        fprintf(stderr, "eval_rpn: NOT case -> malformed rpn expression");
-                        exit(EXIT_FAILURE);
+
+            case RPN_OP: {
+                if (instr->arg.op == NOT) {
+                    if (size < 1) {
+                        fprintf(error_stream(), "eval_rpn: NOT case -> malformed rpn expression");
+                        program_error();
                     }
-                    const t_expr_token t = pop(&stack);
-                    const int a = get_value(var_table, &t);
-                    t_expr_token token_res;
-                    token_res.type = NUMBER;
-                    token_res.content.val = apply_op(token.content.op, a, 0);
-                    push(&stack, token_res);
+                    stack[size - 1] = apply_op(instr->arg.op, stack[size - 1], 0);
                     break;
                 }
-                if (stack.list.size < 2) {
-                    fprintf(stderr, "eval_rpn: malformed rpn expression");
-                    exit(EXIT_FAILURE);
+                if (size < 2) {
+                    fprintf(error_stream(), "eval_rpn: malformed rpn expression");
+                    program_error();
                 }
 
-                const t_expr_token t = pop(&stack);
-                const int b = get_value(var_table, &t);
-                const t_expr_token t2 = pop(&stack);
-                const int a = get_value(var_table, &t2);
-
-                t_expr_token token_res;
-                token_res.type = NUMBER;
-                token_res.content.val = apply_op(token.content.op, a, b);
-                push(&stack, token_res);
+                const int b = stack[--size];
+                const int a = stack[size - 1];
+                stack[size - 1] = apply_op(instr->arg.op, a, b);
                 break;
             }
-            case STRING:
-                fprintf(stderr, "eval_rpn: string found in rpn expression");
-                exit(EXIT_FAILURE);
+
+            // Specialized instructions, only produced from well-formed expressions: the stack is not empty
+            case RPN_SQUARE:
+                stack[size - 1] *= stack[size - 1];
+                break;
+            case RPN_CUBE:
+                stack[size - 1] *= stack[size - 1] * stack[size - 1];
+                break;
+            case RPN_SHL:
+                stack[size - 1] = (int) ((unsigned) stack[size - 1] << instr->arg.shift);
+                break;
+            case RPN_DIV_CONST:
+                stack[size - 1] = apply_div_const(&instr->arg.div, stack[size - 1]);
+                break;
+
+            // Short-circuit of & and |: the right operand and the operator are skipped
+            case RPN_AND_JUMP:
+                if (size > 0 && stack[size - 1] == 0)
+                    i += instr->arg.skip;
+                break;
+            case RPN_OR_JUMP:
+                if (size > 0 && stack[size - 1] != 0) {
+                    stack[size - 1] = 1;
+                    i += instr->arg.skip;
+                }
                 break;
-            case PARENTHESIS:
-                fprintf(stderr, "eval_rpn: parenthesis found in rpn expression\n");
-                exit(EXIT_FAILURE);
         }
     }
 
-    if (is_empty_stack(&stack)) {
-        fprintf(stderr, "eval_rpn: not result get from eval\n");
-        exit(EXIT_FAILURE);
+    if (size == 0) {
+        fprintf(error_stream(), "eval_rpn: not result get from eval\n");
+        program_error();
     }
-    const t_expr_token token_result = get_top(&stack);
-    const int res = get_value(var_table, &token_result);
+    return stack[size - 1];
+}
 
-    destroy_stack(&stack);
-    return res;
+// Appends the token t (of type NUMBER, VARIABLE or OPERATOR) to the compiled expression
+void add_rpn_instr(t_expr_rpn *expr_rpn, const t_expr_token *t) {
+    t_rpn_instr *instr = &expr_rpn->code[expr_rpn->size];
+    switch (t->type) {
+        case NUMBER:
+            instr->opcode = RPN_CONST;
+            instr->arg.val = t->content.val;
+            break;
+        case VARIABLE:
+            instr->opcode = RPN_VAR;
+            instr->arg.slot = (unsigned char)t->content.var - 'a';
+            break;
+        case OPERATOR:
+            instr->opcode = RPN_OP;
+            instr->arg.op = t->content.op;
+            break;
+        default:
+            error_rpn();
+    }
+    expr_rpn->size++;
 }
 
 // Converts an expression in infix notation to Reverse Polish notation
-t_expr_rpn shunting_yard(t_expr *expr) {
-
+t_expr_rpn shunting_yard(t_expr *expr, t_arena *arena) {
+
+    // The RPN expression has at most as many instructions as the infix expression has tokens, plus one jump
+    // per & or |
+    int capacity = expr->list.size;
+    const t_cell *cell = expr->list.head;
+    for (int i = 0; i < expr->list.size; i++, cell = cell->next) {
+        if (cell->value.type == OPERATOR && (cell->value.content.op == AND || cell->value.content.op == OR))
+            capacity++;
+    }
     t_expr_rpn expr_rpn;
-    expr_rpn.expr.list = create_empty_list();
-    t_expr *output = &expr_rpn.expr;
+    expr_rpn.code = arena_alloc(arena, capacity * sizeof(t_rpn_instr));
+    expr_rpn.size = 0;
 
-    t_stack op_stack = create_empty_stack();
+    t_stack op_stack;
+    op_stack.list = create_empty_arena_list(arena);
     while (!is_empty_expr(expr)) {
         t_expr_token t = get_next_token(expr);
         switch (t.type) {
             case NUMBER:
             case VARIABLE:
-                add_token(output, t);
+                add_rpn_instr(&expr_rpn, &t);
                 break;
             case OPERATOR:
                 while (!is_empty_stack(&op_stack)) {
@@ -288,9 +527,15 @@ t_expr_rpn shunting_yard(t_expr *expr) {
                     if (t2.type != OPERATOR || !takes_priority(t.content.op, t2.content.op)) {
                         break;
                     }
-                    add_token(output, t2);
+                    add_rpn_instr(&expr_rpn, &t2);
                     pop(&op_stack);
                 }
+                // The left operand of & and | is complete: the jump follows it
+                if (t.content.op == AND || t.content.op == OR) {
+                    t_rpn_instr *jump = &expr_rpn.code[expr_rpn.size++];
+                    jump->opcode = t.content.op == AND ? RPN_AND_JUMP : RPN_OR_JUMP;
+                    jump->arg.skip = 0;
+                }
                 push(&op_stack, t);
                 break;
             case PARENTHESIS:
@@ -305,16 +550,16 @@ t_expr_rpn shunting_yard(t_expr *expr) {
                             parenthesis_found = true;
                             break;
                         }
-                        add_token(output, t2);
+                        add_rpn_instr(&expr_rpn, &t2);
                     }
                     if (!parenthesis_found) {
-                        printf("Error, missing parenthesis\n");
-                        exit(EXIT_FAILURE);
+                        fprintf(error_stream(), "Error, missing parenthesis\n");
+                        program_error();
                     }
                 }
                 break;
             case STRING:
-                fprintf(stderr, "eval_rpn: string found in rpn expression");
+                fprintf(error_stream(), "eval_rpn: string found in rpn expression");
                 break;
         }
     }
@@ -322,14 +567,15 @@ t_expr_rpn shunting_yard(t_expr *expr) {
     while (!is_empty_stack(&op_stack)) {
         t_expr_token t = pop(&op_stack);
         if (t.type != OPERATOR) {
-            printf("Error, expression is wrongly formed\n");
-            exit(EXIT_FAILURE);
+            fprintf(error_stream(), "Error, expression is wrongly formed\n");
+            program_error();
         }
-        add_token(output, t);
+        add_rpn_instr(&expr_rpn, &t);
     }
 
     destroy_expr(expr);
     destroy_stack(&op_stack);
+    update_max_depth_rpn(&expr_rpn);
     return expr_rpn;
 }
 
@@ -337,8 +583,8 @@ char* get_string_value(const t_expr_token *t) {
     if (t->type == STRING) {
         return t->content.string;
     }
-    fprintf(stderr, "get_string_value: string token expected");
-    exit(EXIT_FAILURE);
+    fprintf(error_stream(), "get_string_value: string token expected");
+    program_error();
 }
 
 char* eval_string_expr(const t_expr *expr) {
@@ -346,81 +592,7 @@ char* eval_string_expr(const t_expr *expr) {
     return get_string_value(&string);
 }
 
-void simplify_constant_subexpressions_rpn(t_expr_rpn *expr_rpn) {
-    t_stack res_stack = create_empty_stack();
-    bool change = true;
-
-    while (change) {
-        change = false;
-        while (!is_empty_expr(&expr_rpn->expr)) {
-            const t_expr_token t = get_next_token(&expr_rpn->expr);
-            switch (t.type) {
-                case NUMBER:
-                case VARIABLE:
-                    push(&res_stack, t);
-                    break;
-                case OPERATOR:
-                    if (t.content.op == 'N') {
-                        if (is_empty_stack(&res_stack)) {
-                            fprintf(stderr, "simplify_constant_subexpressions_rpn: malformed rpn expr");
-                            exit(EXIT_FAILURE);
-                        }
-                        if (get_top(&res_stack).type == NUMBER) {
-                            t_expr_token t1 = pop(&res_stack);
-                            push(&res_stack, token_of_int(apply_op(t.content.op, get_value(nullptr, &t1), 0)));
-                            change = true;
-                        } else {
-                            push(&res_stack, t);
-                        }
-                        break;
-                    }
-                    if (res_stack.list.size < 2) {
-                        fprintf(stderr, "simplify_constant_subexpressions_rpn: malformed rpn expr");
-                        exit(EXIT_FAILURE);
-                    }
-                    t_expr_token t1 = pop(&res_stack);
-                    t_expr_token t2 = pop(&res_stack);
-                    if (t1.type == NUMBER && t2.type == NUMBER) {
-                        push(&res_stack, token_of_int(apply_op(
-                            t.content.op,
-                            get_value(nullptr, &t2),
-                            get_value(nullptr, &t1)
-                        )));
-                        change = true;
-                    } else {
-                        // Push back in correct RPN order: operand2, operand1, operator
-                        push(&res_stack, t2);
-                        push(&res_stack, t1);
-                        push(&res_stack, t);
-                    }
-                    break;
-                default:
-                    fprintf(stderr, "simplify_constant_subexpressions_rpn: malformed rpn expr");
-                    exit(EXIT_FAILURE);
-            }
-        }
-        while (!is_empty_stack(&res_stack)) {
-            push_front(&expr_rpn->expr.list, pop(&res_stack));
-        }
-    }
-}
-
-void precompute_constant_expr_rpn(t_expr_rpn *expr_rpn) {
-    if (!is_constant_expr_rpn(expr_rpn)) {
-        fprintf(stderr, "precompute_constant_expr_rpn: not a constant expr");
-        exit(EXIT_FAILURE);
-    }
-    t_expr *new_expr = malloc(sizeof(t_expr));
-    new_expr->list = create_empty_list();
-    add_token(new_expr, token_of_int(eval_rpn(nullptr, expr_rpn)));
-    destroy_expr(&expr_rpn->expr);
-    expr_rpn->expr = *new_expr;
-}
-
 void destroy_expr(t_expr *expr) {
     destroy_list(&expr->list);
 }
 
-void destroy_expr_rpn(t_expr_rpn *expr_rpn) {
-    destroy_expr(&expr_rpn->expr);
-}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 
 #include "expressions/operator.h"
+#include "program/error.h"
 
 // Returns the operator corresponding to the character c
 operator_type operator_of_char(char c) {
@@ -37,7 +38,7 @@ operator_type operator_of_char(char c) {
         case 'N':
             return NOT;
         default:
-            exit(EXIT_FAILURE);
+            program_error();
     }
 }
 
@@ -66,8 +67,8 @@ int apply_op(operator_type op, int a, int b) {
             return a * b;
         case DIV:
             if (b == 0) {
-                fprintf(stderr, "Division by zero\n");
-                exit(EXIT_FAILURE);
+                fprintf(error_stream(), "Division by zero\n");
+                program_error();
             }
             return a / b;
         case EXP:
@@ -93,8 +94,8 @@ int apply_op(operator_type op, int a, int b) {
         case NOT:
             return !a; // b is ignored
         default:
-            fprintf(stderr, "Unknown operator in apply_op\n");
-            exit(EXIT_FAILURE);
+            fprintf(error_stream(), "Unknown operator in apply_op\n");
+            program_error();
     }
 }
 
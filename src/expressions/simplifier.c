@@ -0,0 +1,388 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "expressions/simplifier.h"
+#include "program/error.h"
+
+// Expressions of at most this many instructions are simplified in local arrays
+#define SIMPLE_LOCAL_SIZE 64
+
+// Node of the tree of an expression: an instruction and the nodes of its operands
+typedef struct {
+    t_rpn_instr instr;
+    int left;           // operands, -1 if none
+    int right;
+    int size;           // number of instructions of the subtree
+    bool safe;          // the subtree cannot stop the program
+    bool boolean;       // the value of the subtree is 0 or 1
+} t_simple_node;
+
+bool is_op_node(const t_simple_node *nodes, const int i, const operator_type op) {
+    return nodes[i].instr.opcode == RPN_OP && nodes[i].instr.arg.op == op;
+}
+
+bool is_const_node(const t_simple_node *nodes, const int i, int *value) {
+    if (i < 0 || nodes[i].instr.opcode != RPN_CONST)
+        return false;
+    *value = nodes[i].instr.arg.val;
+    return true;
+}
+
+bool is_comparison(const operator_type op) {
+    return op >= EQUAL && op <= GEQ;
+}
+
+// & and | are not: their left operand is evaluated first and can skip the right one
+bool is_commutative(const operator_type op) {
+    return op == ADD || op == MULT || op == EQUAL || op == DIFF || op == XOR;
+}
+
+// Recomputes the size and the properties of the node from its operands
+void update_simple_node(t_simple_node *nodes, const int i) {
+    t_simple_node *node = &nodes[i];
+    node->size = 1;
+    node->safe = true;
+    node->boolean = node->instr.opcode == RPN_CONST && (unsigned) node->instr.arg.val <= 1;
+    if (node->left >= 0) {
+        node->size += nodes[node->left].size;
+        node->safe = nodes[node->left].safe;
+    }
+    if (node->right >= 0) {
+        node->size += nodes[node->right].size;
+        node->safe = node->safe && nodes[node->right].safe;
+    }
+    if (node->instr.opcode != RPN_OP)
+        return;
+    const operator_type op = node->instr.arg.op;
+    int divisor;
+    if (op == DIV && !(is_const_node(nodes, node->right, &divisor) && divisor != 0 && divisor != -1))
+        node->safe = false;
+    node->boolean = is_comparison(op) || op == AND || op == OR || op == XOR || op == NOT;
+}
+
+// The node becomes the constant value, returns it
+int set_const_node(t_simple_node *nodes, const int i, const int value) {
+    nodes[i].instr.opcode = RPN_CONST;
+    nodes[i].instr.arg.val = value;
+    nodes[i].left = -1;
+    nodes[i].right = -1;
+    update_simple_node(nodes, i);
+    return i;
+}
+
+// Returns true if the subtrees a and b are the same instructions; stack holds 2 * size(a) indices
+bool same_subtree(const t_simple_node *nodes, const int a, const int b, int *stack) {
+    if (nodes[a].size != nodes[b].size)
+        return false;
+    int size = 0;
+    stack[size++] = a;
+    stack[size++] = b;
+    while (size > 0) {
+        const t_simple_node *x = &nodes[stack[--size]];
+        const t_simple_node *y = &nodes[stack[--size]];
+        if (x->instr.opcode != y->instr.opcode || x->instr.arg.val != y->instr.arg.val
+            || (x->left < 0) != (y->left < 0) || (x->right < 0) != (y->right < 0))
+            return false;
+        if (x->left >= 0) {
+            stack[size++] = x->left;
+            stack[size++] = y->left;
+        }
+        if (x->right >= 0) {
+            stack[size++] = x->right;
+            stack[size++] = y->right;
+        }
+    }
+    return true;
+}
+
+int simplify_node(t_simple_node *nodes, int i, int *stack);
+
+// Chains of the associative operator op (+ or *) keep their only constant at the top:
+// (x op c) op y and x op (y op c) become (x op y) op c
+// Returns the simplified node
+int float_constant(t_simple_node *nodes, const int i, const operator_type op, int *stack) {
+    t_simple_node *node = &nodes[i];
+    const int a = node->left;
+    const int b = node->right;
+    int c;
+    int chain, constant;
+    if (is_op_node(nodes, a, op) && is_const_node(nodes, nodes[a].right, &c)) {
+        chain = a;
+        constant = nodes[a].right;
+        nodes[a].right = b;
+    } else if (is_op_node(nodes, b, op) && is_const_node(nodes, nodes[b].right, &c)) {
+        chain = b;
+        constant = nodes[b].right;
+        nodes[b].right = nodes[b].left;
+        nodes[b].left = a;
+    } else {
+        return i;
+    }
+    node->left = simplify_node(nodes, chain, stack);
+    node->right = constant;
+    return simplify_node(nodes, i, stack);
+}
+
+// Operator N: constants, double negations of a boolean and negations of comparisons
+int simplify_not(t_simple_node *nodes, const int i) {
+    static const operator_type inverse[] = {
+        [EQUAL] = DIFF, [DIFF] = EQUAL, [LESS] = GEQ, [GREATER] = LEQ, [LEQ] = GREATER, [GEQ] = LESS
+    };
+    const int a = nodes[i].left;
+    int value;
+    if (is_const_node(nodes, a, &value))
+        return set_const_node(nodes, i, !value);
+    if (is_op_node(nodes, a, NOT) && nodes[nodes[a].left].boolean)
+        return nodes[a].left;
+    if (nodes[a].instr.opcode == RPN_OP && is_comparison(nodes[a].instr.arg.op)) {
+        nodes[a].instr.arg.op = inverse[nodes[a].instr.arg.op];
+        return a;
+    }
+    return i;
+}
+
+// Applies the local rules to the node, whose operands are already simplified
+// Returns the node of the result, which replaces the node in its parent
+// Each rule only looks at the node and its operands; a rule that reshapes them simplifies the reshaped nodes
+// again, whose operands are simplified: the number of rules applied is bounded by a constant per node
+int simplify_node(t_simple_node *nodes, const int i, int *stack) {
+    t_simple_node *node = &nodes[i];
+    update_simple_node(nodes, i);
+    if (node->instr.opcode != RPN_OP)
+        return i;
+    operator_type op = node->instr.arg.op;
+    if (op == NOT)
+        return simplify_not(nodes, i);
+
+    int va = 0, vb = 0, c;
+    // The constant operand of a commutative operator goes to the right
+    if (is_commutative(op) && is_const_node(nodes, node->left, &va) && !is_const_node(nodes, node->right, &vb)) {
+        const int constant = node->left;
+        node->left = node->right;
+        node->right = constant;
+    }
+    const int a = node->left;
+    const int b = node->right;
+    const bool ca = is_const_node(nodes, a, &va);
+    const bool cb = is_const_node(nodes, b, &vb);
+    if (ca && cb) {
+        if (op == DIV && (vb == 0 || (va == INT_MIN && vb == -1)))
+            return i;
+        return set_const_node(nodes, i, apply_op(op, va, vb));
+    }
+    // x - c is x + (-c): the constants of the chains of + and - are all added
+    if (cb && op == SUB) {
+        node->instr.arg.op = op = ADD;
+        set_const_node(nodes, b, vb = (int) (0u - (unsigned) vb));
+    }
+    switch (op) {
+        case ADD:
+        case MULT:
+            if (!cb)
+                return float_constant(nodes, i, op, stack);
+            if (vb == (op == ADD ? 0 : 1))
+                return a;
+            if (op == MULT && vb == 0)
+                return nodes[a].safe ? set_const_node(nodes, i, 0) : i;
+            if (is_op_node(nodes, a, op) && is_const_node(nodes, nodes[a].right, &c)) {
+                // (x op c) op vb is x op (c op vb)
+                set_const_node(nodes, nodes[a].right, op == ADD ? (int) ((unsigned) c + (unsigned) vb)
+                                                                : (int) ((unsigned) c * (unsigned) vb));
+                return simplify_node(nodes, a, stack);
+            }
+            if (op == ADD && is_op_node(nodes, a, SUB) && is_const_node(nodes, nodes[a].left, &c)) {
+                // (c - x) + vb is (c + vb) - x
+                set_const_node(nodes, nodes[a].left, (int) ((unsigned) c + (unsigned) vb));
+                return simplify_node(nodes, a, stack);
+            }
+            return i;
+        case SUB:
+            if (nodes[a].safe && same_subtree(nodes, a, b, stack))
+                return set_const_node(nodes, i, 0);
+            if (ca && is_op_node(nodes, b, ADD) && is_const_node(nodes, nodes[b].right, &c)) {
+                // va - (y + c) is (va - c) - y
+                set_const_node(nodes, a, (int) ((unsigned) va - (unsigned) c));
+                node->right = nodes[b].left;
+                return simplify_node(nodes, i, stack);
+            }
+            if (is_op_node(nodes, a, ADD) && is_const_node(nodes, nodes[a].right, &c)) {
+                // (x + c) - y is (x - y) + c
+                const int constant = nodes[a].right;
+                nodes[a].instr.arg.op = SUB;
+                nodes[a].right = b;
+                node->instr.arg.op = ADD;
+                node->left = simplify_node(nodes, a, stack);
+                node->right = constant;
+                return simplify_node(nodes, i, stack);
+            }
+            if (is_op_node(nodes, b, ADD) && is_const_node(nodes, nodes[b].right, &c)) {
+                // x - (y + c) is (x - y) + (-c)
+                const int constant = nodes[b].right;
+                set_const_node(nodes, constant, (int) (0u - (unsigned) c));
+                nodes[b].instr.arg.op = SUB;
+                nodes[b].right = nodes[b].left;
+                nodes[b].left = a;
+                node->instr.arg.op = ADD;
+                node->left = simplify_node(nodes, b, stack);
+                node->right = constant;
+                return simplify_node(nodes, i, stack);
+            }
+            return i;
+        case DIV:
+            return cb && vb == 1 ? a : i;
+        case EXP:
+            // fast_exp(): x ^ 1 and x ^ b for a negative b are x
+            if (cb && (vb == 1 || vb < 0))
+                return a;
+            if (cb && vb == 0)
+                return nodes[a].safe ? set_const_node(nodes, i, 1) : i;
+            if (ca && va == 1)
+                return nodes[b].safe ? set_const_node(nodes, i, 1) : i;
+            return i;
+        case EQUAL:
+        case DIFF:
+        case LESS:
+        case GREATER:
+        case LEQ:
+        case GEQ:
+            if (nodes[a].safe && same_subtree(nodes, a, b, stack))
+                return set_const_node(nodes, i, op == EQUAL || op == LEQ || op == GEQ);
+            return i;
+        // A constant left operand decides alone, or leaves the right operand: 0 & y is 0 even if y stops the program
+        case AND:
+            if (ca)
+                return va == 0 ? set_const_node(nodes, i, 0) : nodes[b].boolean ? b : i;
+            if (cb && vb == 0)
+                return nodes[a].safe ? set_const_node(nodes, i, 0) : i;
+            return cb && nodes[a].boolean ? a : i;
+        case OR:
+            if (ca)
+                return va != 0 ? set_const_node(nodes, i, 1) : nodes[b].boolean ? b : i;
+            if (cb && vb != 0)
+                return nodes[a].safe ? set_const_node(nodes, i, 1) : i;
+            return cb && nodes[a].boolean ? a : i;
+        case XOR:
+            if (cb && vb != 0) {
+                // x X c is N x
+                node->instr.arg.op = NOT;
+                node->right = -1;
+                update_simple_node(nodes, i);
+                return simplify_not(nodes, i);
+            }
+            if (cb)
+                return nodes[a].boolean ? a : i;
+            if (nodes[a].safe && same_subtree(nodes, a, b, stack))
+                return set_const_node(nodes, i, 0);
+            return i;
+        default:
+            return i;
+    }
+}
+
+void free_simple_arrays(t_simple_node *nodes, int *roots, const bool local) {
+    if (!local) {
+        free(nodes);
+        free(roots);
+    }
+}
+
+void simplify_expr_rpn(t_expr_rpn *expr_rpn, const bool report_division_by_zero) {
+    const int n = expr_rpn->size;
+    if (n == 0) {
+        fprintf(error_stream(), "simplify_expr_rpn: empty expression\n");
+        program_error();
+    }
+    if (n == 1 && (expr_rpn->code[0].opcode == RPN_CONST || expr_rpn->code[0].opcode == RPN_VAR)) {
+        update_max_depth_rpn(expr_rpn);
+        return;
+    }
+    // The arrays of the usual expressions are local: no allocation
+    t_simple_node local_nodes[SIMPLE_LOCAL_SIZE];
+    int local_ints[3 * SIMPLE_LOCAL_SIZE + 2];
+    const bool local = n <= SIMPLE_LOCAL_SIZE;
+    t_simple_node *nodes = local ? local_nodes : malloc(n * sizeof(t_simple_node));
+    int *roots = local ? local_ints : malloc((3 * n + 2) * sizeof(int));
+    int *stack = roots + n;
+
+    // Tree of the expression, built and simplified bottom-up: roots holds the subtrees not yet used as operands
+    int nb_roots = 0;
+    for (int i = 0; i < n; i++) {
+        // The jumps are emitted again with the trees
+        if (expr_rpn->code[i].opcode == RPN_AND_JUMP || expr_rpn->code[i].opcode == RPN_OR_JUMP)
+            continue;
+        t_simple_node *node = &nodes[i];
+        node->instr = expr_rpn->code[i];
+        node->left = -1;
+        node->right = -1;
+        if (node->instr.opcode == RPN_CONST || node->instr.opcode == RPN_VAR) {
+            update_simple_node(nodes, i);
+            roots[nb_roots++] = i;
+            continue;
+        }
+        const int arity = node->instr.opcode == RPN_OP && node->instr.arg.op != NOT ? 2 : 1;
+        if (nb_roots < arity) {
+            free_simple_arrays(nodes, roots, local);
+            fprintf(error_stream(), "simplify_expr_rpn: malformed rpn expr\n");
+            program_error();
+        }
+        if (arity == 2)
+            node->right = roots[--nb_roots];
+        node->left = roots[--nb_roots];
+        // The operands are folded already: a constant divided by a constant zero stops the compilation, even where
+        // the division would be skipped (0 & 1 / 0)
+        int dividend, divisor;
+        if (report_division_by_zero && is_op_node(nodes, i, DIV) && is_const_node(nodes, node->left, &dividend)
+            && is_const_node(nodes, node->right, &divisor) && divisor == 0) {
+            free_simple_arrays(nodes, roots, local);
+            fprintf(error_stream(), "Division by zero\n");
+            program_error();
+        }
+        roots[nb_roots++] = simplify_node(nodes, i, stack);
+    }
+
+    // Instructions of the trees in postorder, written over the expression (the trees have at most n nodes)
+    // A jump follows the left operand of each & and | whose right operand is not a single value, as long as the
+    // jumps of the expression are enough (the simplification never creates an & or an |)
+    int nb_jumps = n;
+    for (int r = 0; r < nb_roots; r++)
+        nb_jumps -= nodes[roots[r]].size;
+    int size = 0;
+    for (int r = 0; r < nb_roots; r++) {
+        int top = 0;
+        stack[top++] = roots[r];
+        while (top > 0) {
+            const int i = stack[--top];
+            if (i < 0) {
+                expr_rpn->code[size++] = nodes[~i].instr;
+                continue;
+            }
+            if (i >= n) {
+                t_rpn_instr *jump = &expr_rpn->code[size++];
+                jump->opcode = is_op_node(nodes, i - n, AND) ? RPN_AND_JUMP : RPN_OR_JUMP;
+                jump->arg.skip = 0;
+                continue;
+            }
+            // The additions of negative constants are subtractions: [x 3 -] rather than [x -3 +]
+            int value;
+            if (is_op_node(nodes, i, ADD) && is_const_node(nodes, nodes[i].right, &value)
+                && value < 0 && value != INT_MIN) {
+                nodes[i].instr.arg.op = SUB;
+                nodes[nodes[i].right].instr.arg.val = -value;
+            }
+            stack[top++] = ~i;
+            if (nodes[i].right >= 0)
+                stack[top++] = nodes[i].right;
+            if ((is_op_node(nodes, i, AND) || is_op_node(nodes, i, OR)) && nodes[nodes[i].right].size > 1
+                && nb_jumps > 0) {
+                stack[top++] = n + i;
+                nb_jumps--;
+            }
+            if (nodes[i].left >= 0)
+                stack[top++] = nodes[i].left;
+        }
+    }
+    expr_rpn->size = size;
+    free_simple_arrays(nodes, roots, local);
+    update_max_depth_rpn(expr_rpn);
+}
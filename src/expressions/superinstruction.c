@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "expressions/superinstruction.h"
+
+bool super_stats_enabled = false;
+unsigned long super_hits[NB_SUPERINSTRUCTIONS];
+
+int compare_super_hits(const void *a, const void *b) {
+    const unsigned long hits_a = super_hits[*(const int *) a];
+    const unsigned long hits_b = super_hits[*(const int *) b];
+    return hits_a < hits_b ? 1 : (hits_a > hits_b ? -1 : *(const int *) a - *(const int *) b);
+}
+
+// Writes the superinstruction as a pattern: "x < c", "x = x + c"
+void print_super_pattern(FILE *file, const int super) {
+    const e_rpn_shape shape = super / NB_OPERATORS;
+    const operator_type op = super % NB_OPERATORS;
+    switch (shape) {
+        case SHAPE_GENERIC:
+            fprintf(file, "(generic)");
+            return;
+        case SHAPE_CONST:
+            fprintf(file, "c");
+            return;
+        case SHAPE_VAR:
+            fprintf(file, "x");
+            return;
+        case SHAPE_VAR_SPECIAL: {
+            // In the order of the specialized instructions, from RPN_SQUARE
+            static const char *special[] = {"x ^ 2", "x ^ 3", "x << k", "x / c"};
+            fprintf(file, "%s", special[op]);
+            return;
+        }
+        default:
+            break;
+    }
+    const char *left = shape == SHAPE_CONST_OP_VAR ? "c" : "x";
+    const char *right = shape == SHAPE_VAR_OP_VAR ? "y" : (shape == SHAPE_CONST_OP_VAR ? "x" : "c");
+    fprintf(file, "%s%s ", shape == SHAPE_UPDATE ? "x = " : "", left);
+    print_operator_file(file, op);
+    fprintf(file, " %s", right);
+}
+
+void print_super_stats(FILE *file) {
+    int used[NB_SUPERINSTRUCTIONS];
+    int nb_used = 0;
+    unsigned long total = 0;
+    for (int i = 0; i < NB_SUPERINSTRUCTIONS; i++) {
+        if (super_hits[i] > 0)
+            used[nb_used++] = i;
+        total += super_hits[i];
+    }
+    qsort(used, nb_used, sizeof(int), compare_super_hits);
+
+    fprintf(file, "%14s %7s  %s\n", "hits", "%", "superinstruction");
+    for (int k = 0; k < nb_used; k++) {
+        fprintf(file, "%14lu %6.2f%%  ", super_hits[used[k]], 100.0 * super_hits[used[k]] / total);
+        print_super_pattern(file, used[k]);
+        fprintf(file, "\n");
+    }
+    fprintf(file, "%14lu evaluations\n", total);
+}
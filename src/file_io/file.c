@@ -1,20 +1,102 @@
 #include "file_io/file.h"
+#include "program/error.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-char *read_file(const char *file_name) {
-    
-    FILE *file = fopen(file_name, "rb");
-    if (file == NULL) {
-        printf("Error: file %s not found\n", file_name);
-        return NULL;
+#define READ_BUFFER_SIZE (64 * 1024)
+
+// Maps the regular file of size bytes
+// The mapping is placed at the start of a zeroed region one page longer than needed:
+// data[size] is '\0' even when size is a multiple of the page size
+bool map_source(const int fd, const size_t size, t_source *source) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    const size_t file_pages = (size + page_size - 1) / page_size * page_size;
+    const size_t map_size = file_pages + page_size;
+
+    char *region = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED)
+        return false;
+    if (mmap(region, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(region, map_size);
+        return false;
+    }
+    // The lexer reads the source once, from the start to the end
+    madvise(region, file_pages, MADV_SEQUENTIAL);
+
+    source->data = region;
+    source->size = size;
+    source->map = region;
+    source->map_size = map_size;
+    return true;
+}
+
+// Reads the stream until its end into a buffer (pipes, stdin, files that cannot be mapped)
+bool read_source(const int fd, t_source *source) {
+    size_t capacity = READ_BUFFER_SIZE;
+    size_t size = 0;
+    char *buffer = malloc(capacity + 1);
+    while (true) {
+        if (size == capacity) {
+            capacity *= 2;
+            buffer = realloc(buffer, capacity + 1);
+        }
+        const ssize_t n = read(fd, buffer + size, capacity - size);
+        if (n == 0)
+            break;
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            free(buffer);
+            return false;
+        }
+        size += n;
+    }
+    buffer[size] = '\0';
+
+    source->data = buffer;
+    source->size = size;
+    source->map = NULL;
+    source->map_size = 0;
+    return true;
+}
+
+bool load_source(const char *file_name, t_source *source) {
+    const bool is_stdin = strcmp(file_name, "-") == 0;
+    const int fd = is_stdin ? STDIN_FILENO : open(file_name, O_RDONLY);
+    if (fd < 0) {
+        fprintf(error_stream(), "Error: cannot open file %s (%s)\n", file_name, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    bool loaded = false;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        loaded = map_source(fd, st.st_size, source);
+    if (!loaded) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        loaded = read_source(fd, source);
     }
-    fseek(file, 0, SEEK_END);
-    const unsigned int file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char *buffer = malloc((file_size + 1) * sizeof(char));
-    fread(buffer, sizeof(char), file_size, file);
-    fclose(file);
-    buffer[file_size] = '\0';
-    return buffer;
-}
\ No newline at end of file
+    if (!loaded)
+        fprintf(error_stream(), "Error: cannot read file %s (%s)\n", file_name, strerror(errno));
+
+    if (!is_stdin)
+        close(fd);
+    return loaded;
+}
+
+void release_source(t_source *source) {
+    if (source->map != NULL)
+        munmap(source->map, source->map_size);
+    else
+        free((char *) source->data);
+    source->data = NULL;
+    source->size = 0;
+    source->map = NULL;
+    source->map_size = 0;
+}
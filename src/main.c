@@ -1,11 +1,23 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
 #include "file_io/file.h"
 #include "program/lexer.h"
 #include "program/parser.h"
 #include "program/program.h"
+#include "program/compilation.h"
+#include "program/batch.h"
+#include "program/cache.h"
 #include "program/run.h"
+#include "program/stream.h"
+#include "program/sweep.h"
+#include "program/c_emitter.h"
 #include "structures/prog_token_list.h"
+#include "structures/task_pool.h"
 
 void example() {
 
@@ -21,17 +33,23 @@ void example() {
     char *code = "a = 1\nif a\n    print 2\nelse\n    print 3\nreturn a";
 
     // Token list
-    // Creation of the tokens (of type t_prog_token)
+    // Creation of the tokens (of type t_prog_token), their expressions are allocated in the arena
+    t_arena arena = create_arena();
     const char *s1 = "1";
-    t_expr_rpn expr_1 = { .expr = parse_expr(&s1) };
+    t_expr e1 = parse_expr(&s1, &arena);
+    t_expr_rpn expr_1 = shunting_yard(&e1, &arena);
     const char *s2 = "a";
-    t_expr_rpn expr_2 = { .expr = parse_expr(&s2) };
+    t_expr e2 = parse_expr(&s2, &arena);
+    t_expr_rpn expr_2 = shunting_yard(&e2, &arena);
     const char *s3 = "2";
-    t_expr_rpn expr_3 = { .expr = parse_expr(&s3) };
+    t_expr e3 = parse_expr(&s3, &arena);
+    t_expr_rpn expr_3 = shunting_yard(&e3, &arena);
     const char *s4 = "3";
-    t_expr_rpn expr_4 = { .expr = parse_expr(&s4) };
+    t_expr e4 = parse_expr(&s4, &arena);
+    t_expr_rpn expr_4 = shunting_yard(&e4, &arena);
     const char *s5 = "a";
-    t_expr_rpn expr_5 = { .expr = parse_expr(&s5) };
+    t_expr e5 = parse_expr(&s5, &arena);
+    t_expr_rpn expr_5 = shunting_yard(&e5, &arena);
 #define LEN_TOKEN_LIST 13
     t_prog_token array[LEN_TOKEN_LIST] = {
         { PT_VAR, {.var = 'a'}},                // a
@@ -76,33 +94,244 @@ void example() {
     node_5.statement = (u_statement) { .return_st = {.expr = expr_5 }};
     node_5.next = NULL;
     // t_ast *prog_example = &node_1;
-    t_ast *prog_example = parse(&token_list);
+    t_ast *prog_example = parse(&token_list, &arena);
     // Checking that the AST is correctly drawn
     //print_ast(prog_example, "../output/code_ex.mmd");
 
     // Execution of the program
-    run(prog_example);
+    run(prog_example, stdout);
     /*
      Expected display:
         2
         -> 1
     */
+    ptl_destroy_list(&token_list);
+    destroy_arena(&arena);
 }
 
 
-int main() {
+// When the AST is exported
+typedef enum {
+    EXPORT_SYNC,    // after the execution
+    EXPORT_ASYNC,   // on a background thread, during the execution
+    EXPORT_NONE
+} e_export_mode;
+
+typedef struct {
+    const t_program *program;
+    const char *file_name;
+} t_export_args;
+
+void *export_thread(void *p_args) {
+    const t_export_args *args = p_args;
+    export_compiled_program(args->program, args->file_name);
+    return NULL;
+}
+
+void usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s [--engine=ast|vm|jit] [--check] [--super-stats] [--opt-stats] [--no-export|--export-async] [--mem-stats] [--lex-jobs=N] [--cache] [--profile] [file|-]\n", prog_name);
+    fprintf(stderr, "       %s --emit-c=output.c [file]\n", prog_name);
+    fprintf(stderr, "       %s --stream [--mem-stats] [--super-stats] [file|-]\n", prog_name);
+    fprintf(stderr, "       %s --batch [--jobs=N] [--engine=ast|vm|jit] file|directory...\n", prog_name);
+    fprintf(stderr, "       %s --sweep=envs.txt [--jobs=N] [file|-]\n", prog_name);
+}
+
+int main(int argc, char **argv) {
 
     // example();
     // return EXIT_SUCCESS;
 
     const char *file_name = "../code/code.txt";
-    char *code = read_file(file_name);
-    if (code == NULL)
+    t_run_options options = { .engine = ENGINE_AST, .mem_stats = false, .output = NULL,
+                             .lex_threads = nb_available_cores() };
+    e_export_mode export_mode = EXPORT_SYNC;
+    bool batch = false;
+    bool use_cache = false;
+    bool ast_engine_asked = false;
+    bool stream = false;
+    bool check = false;
+    bool super_stats = false;
+    bool opt_stats = false;
+    bool profile = false;
+    const char *c_file_name = NULL;
+    const char *sweep_file_name = NULL;
+    int nb_threads = nb_available_cores();
+    char **batch_paths = malloc(argc * sizeof(char *));
+    int nb_batch_paths = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--engine=ast") == 0) {
+            options.engine = ENGINE_AST;
+            ast_engine_asked = true;
+        } else if (strcmp(argv[i], "--engine=vm") == 0) {
+            options.engine = ENGINE_VM;
+            ast_engine_asked = false;
+        } else if (strcmp(argv[i], "--engine=jit") == 0) {
+            options.engine = ENGINE_JIT;
+            ast_engine_asked = false;
+        } else if (strncmp(argv[i], "--emit-c=", 9) == 0 && argv[i][9] != '\0') {
+            c_file_name = argv[i] + 9;
+        } else if (strncmp(argv[i], "--sweep=", 8) == 0 && argv[i][8] != '\0') {
+            sweep_file_name = argv[i] + 8;
+        } else if (strcmp(argv[i], "--super-stats") == 0) {
+            super_stats = true;
+        } else if (strcmp(argv[i], "--opt-stats") == 0) {
+            opt_stats = true;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else if (strcmp(argv[i], "--mem-stats") == 0) {
+            options.mem_stats = true;
+        } else if (strcmp(argv[i], "--no-export") == 0) {
+            export_mode = EXPORT_NONE;
+        } else if (strcmp(argv[i], "--export-async") == 0) {
+            export_mode = EXPORT_ASYNC;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            use_cache = true;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = true;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+        } else if (strncmp(argv[i], "--jobs=", 7) == 0 && atoi(argv[i] + 7) > 0) {
+            nb_threads = atoi(argv[i] + 7);
+        } else if (strncmp(argv[i], "--lex-jobs=", 11) == 0 && atoi(argv[i] + 11) > 0) {
+            options.lex_threads = atoi(argv[i] + 11);
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            free(batch_paths);
+            return EXIT_FAILURE;
+        } else {
+            file_name = argv[i];
+            batch_paths[nb_batch_paths++] = argv[i];
+        }
+    }
+
+    // Batch mode: every script is compiled and run, nothing is exported
+    if (batch) {
+        int nb_files;
+        char **files = list_batch_files(batch_paths, nb_batch_paths, &nb_files);
+        free(batch_paths);
+        const int nb_failed = run_batch(files, nb_files, nb_threads, &options);
+        destroy_batch_files(files, nb_files);
+        return nb_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    free(batch_paths);
+
+    // Streaming mode: the program is executed while it is read, nothing is compiled ahead, cached or exported
+    if (stream) {
+        const bool is_stdin = strcmp(file_name, "-") == 0;
+        const int fd = is_stdin ? STDIN_FILENO : open(file_name, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "Error: cannot open file %s (%s)\n", file_name, strerror(errno));
+            return EXIT_FAILURE;
+        }
+        super_stats_enabled = super_stats;
+        const bool read = run_stream(fd, &options);
+        if (super_stats)
+            print_super_stats(stderr);
+        if (!is_stdin)
+            close(fd);
+        return read ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    t_source source;
+    if (!load_source(file_name, &source))
         return EXIT_FAILURE;
 
-    run_program(code);
-    export_program_ast(code, file_name);
+    // Sweep: the bytecode runs once per environment, nothing is cached or exported
+    // The variables of the environments are not constants for the optimizer
+    if (sweep_file_name != NULL) {
+        t_sweep_env *envs;
+        int nb_envs;
+        if (!load_sweep_envs(sweep_file_name, &envs, &nb_envs)) {
+            release_source(&source);
+            return EXIT_FAILURE;
+        }
+        t_program *program = compile_program_inputs(source.data, source.size, options.lex_threads,
+                                                     sweep_inputs(envs, nb_envs));
+        release_source(&source);
+        compile_program_bytecode(program);
+        const int nb_failed = run_sweep(&program->bytecode, envs, nb_envs, nb_threads);
+        destroy_program(program);
+        free(envs);
+        return nb_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // A program read on stdin has no file name for its export or its cache file
+    if (strcmp(file_name, "-") == 0) {
+        export_mode = EXPORT_NONE;
+        use_cache = false;
+    }
 
-    free(code);
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    // Lexed, parsed and optimized once, for the execution and the export
+    // The export shows the AST of the source: a copy is kept before the optimization, only when it is exported
+    // With the cache, the bytecode is loaded from the cache file when it is up to date: there is no AST to export
+    // The transpiler and the profile need the AST, the cache file only has the bytecode
+    if (c_file_name != NULL || profile)
+        use_cache = false;
+    t_program *program;
+    if (use_cache) {
+        char cache_file_name[1000];
+        get_cache_file_name(file_name, cache_file_name, sizeof(cache_file_name));
+        program = compile_program_cached(source.data, source.size, cache_file_name, options.lex_threads);
+        // The cache file only has the bytecode: the VM replaces the AST walker, asked for or by default
+        if (ast_engine_asked)
+            fprintf(stderr, "Warning: the cache file has no AST, the program runs on the VM (--engine=vm)\n");
+        if (options.engine == ENGINE_AST)
+            options.engine = ENGINE_VM;
+        export_mode = EXPORT_NONE;
+    } else if (export_mode != EXPORT_NONE && c_file_name == NULL) {
+        program = compile_program_exported(source.data, source.size, options.lex_threads);
+    } else {
+        program = compile_program(source.data, source.size, options.lex_threads);
+    }
+    release_source(&source);
+    if (options.mem_stats)
+        print_arena_stats(stderr, &program->arena);
+    // A program loaded from its cache file was optimized when the file was written
+    if (opt_stats && program->ast != NULL)
+        print_opt_stats(stderr, &program->opt_stats);
+
+    // Transpilation: the program is written in C, it is not executed
+    if (c_file_name != NULL) {
+        FILE *c_file = fopen(c_file_name, "w");
+        if (c_file == NULL) {
+            fprintf(stderr, "Error: cannot open file %s (%s)\n", c_file_name, strerror(errno));
+            destroy_program(program);
+            return EXIT_FAILURE;
+        }
+        emit_c_program(program->ast, file_name, c_file);
+        fclose(c_file);
+        destroy_program(program);
+        return EXIT_SUCCESS;
+    }
+
+    pthread_t thread;
+    t_export_args export_args = { .program = program, .file_name = file_name };
+    if (export_mode == EXPORT_ASYNC)
+        pthread_create(&thread, NULL, export_thread, &export_args);
+
+    // Only the evaluations of the execution are counted, not the ones of the constant folding
+    super_stats_enabled = super_stats;
+
+    // The differential test needs the AST of the reference engine
+    // The profile is measured on the AST walker, its files are named after the source
+    bool checked = true;
+    if (profile)
+        profile_compiled_program(program, &options, strcmp(file_name, "-") == 0 ? "stdin" : file_name);
+    else if (check && program->ast != NULL)
+        checked = check_compiled_program(program, &options);
+    else
+        run_compiled_program(program, &options);
+
+    if (super_stats)
+        print_super_stats(stderr);
+
+    if (export_mode == EXPORT_SYNC)
+        export_compiled_program(program, file_name);
+    if (export_mode == EXPORT_ASYNC)
+        pthread_join(thread, NULL);
+
+    destroy_program(program);
+    return checked ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,183 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "program/batch.h"
+#include "program/compilation.h"
+#include "program/error.h"
+#include "file_io/file.h"
+#include "structures/task_pool.h"
+
+typedef struct {
+    t_batch_script *scripts;
+    const t_run_options *options;
+} t_batch;
+
+double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+bool is_directory(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool has_txt_extension(const char *name) {
+    const size_t len = strlen(name);
+    return len > 4 && strcmp(name + len - 4, ".txt") == 0;
+}
+
+int compare_file_names(const void *a, const void *b) {
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+void add_batch_file(char ***files, int *nb_files, int *capacity, char *file_name) {
+    if (*nb_files >= *capacity) {
+        *capacity = *capacity == 0 ? 16 : 2 * *capacity;
+        *files = realloc(*files, *capacity * sizeof(char *));
+    }
+    (*files)[(*nb_files)++] = file_name;
+}
+
+char **list_batch_files(char **paths, const int nb_paths, int *nb_files) {
+    char **files = NULL;
+    int capacity = 0;
+    *nb_files = 0;
+
+    for (int i = 0; i < nb_paths; i++) {
+        if (!is_directory(paths[i])) {
+            add_batch_file(&files, nb_files, &capacity, strdup(paths[i]));
+            continue;
+        }
+        DIR *dir = opendir(paths[i]);
+        if (dir == NULL) {
+            fprintf(stderr, "Error: cannot open directory %s\n", paths[i]);
+            continue;
+        }
+        const int first = *nb_files;
+        const struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (!has_txt_extension(entry->d_name))
+                continue;
+            char *file_name = malloc(strlen(paths[i]) + strlen(entry->d_name) + 2);
+            sprintf(file_name, "%s/%s", paths[i], entry->d_name);
+            if (is_directory(file_name)) {
+                free(file_name);
+                continue;
+            }
+            add_batch_file(&files, nb_files, &capacity, file_name);
+        }
+        closedir(dir);
+        qsort(files + first, *nb_files - first, sizeof(char *), compare_file_names);
+    }
+    return files;
+}
+
+// Task of the pool: compiles and runs one script, its output and its diagnostics are captured in memory
+void run_batch_script(void *arg, const int index) {
+    const t_batch *batch = arg;
+    t_batch_script *script = &batch->scripts[index];
+    t_run_options options = *batch->options;
+    options.output = open_memstream(&script->output, &script->output_size);
+    FILE *const errors = open_memstream(&script->errors, &script->errors_size);
+    error_output = errors;
+
+    // An error in the script jumps back here instead of exiting the process
+    jmp_buf recovery;
+    t_source *const source = malloc(sizeof(t_source));
+    bool volatile loaded = false;
+    t_program *volatile program = NULL;
+    error_recovery = &recovery;
+    if (setjmp(recovery) == 0) {
+        struct timespec t0, t1, t2;
+        loaded = load_source(script->file_name, source);
+        if (loaded) {
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            // The scripts already run in parallel: each one is lexed on its thread
+            program = compile_program(source->data, source->size, 1);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            script->compile_ms = elapsed_ms(&t0, &t1);
+            run_compiled_program(program, &options);
+            clock_gettime(CLOCK_MONOTONIC, &t2);
+            script->run_ms = elapsed_ms(&t1, &t2);
+        } else {
+            script->error = true;
+        }
+    } else {
+        script->error = true;
+    }
+    error_recovery = NULL;
+    error_output = NULL;
+
+    fclose(options.output);
+    fclose(errors);
+    destroy_program(program);
+    if (loaded)
+        release_source(source);
+    free(source);
+}
+
+int run_batch(char **file_names, const int nb_files, const int nb_threads, const t_run_options *options) {
+    t_batch batch;
+    batch.options = options;
+    batch.scripts = malloc(nb_files * sizeof(t_batch_script));
+    for (int i = 0; i < nb_files; i++) {
+        t_batch_script *script = &batch.scripts[i];
+        script->file_name = file_names[i];
+        script->output = NULL;
+        script->output_size = 0;
+        script->errors = NULL;
+        script->errors_size = 0;
+        script->error = false;
+        script->compile_ms = 0;
+        script->run_ms = 0;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_parallel_tasks(nb_files, nb_threads, run_batch_script, &batch);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    // Outputs, in the order of the inputs: stdout is flushed before the diagnostics, which follow their script
+    for (int i = 0; i < nb_files; i++) {
+        const t_batch_script *script = &batch.scripts[i];
+        fprintf(stdout, "==> %s <==\n", script->file_name);
+        fwrite(script->output, 1, script->output_size, stdout);
+        fflush(stdout);
+        fwrite(script->errors, 1, script->errors_size, stderr);
+    }
+
+    // Summary
+    int nb_failed = 0;
+    double compile_ms = 0;
+    double run_ms = 0;
+    fprintf(stderr, "%12s %12s  %-6s %s\n", "compile (ms)", "run (ms)", "status", "script");
+    for (int i = 0; i < nb_files; i++) {
+        const t_batch_script *script = &batch.scripts[i];
+        fprintf(stderr, "%12.3f %12.3f  %-6s %s\n", script->compile_ms, script->run_ms,
+                script->error ? "error" : "ok", script->file_name);
+        nb_failed += script->error;
+        compile_ms += script->compile_ms;
+        run_ms += script->run_ms;
+    }
+    fprintf(stderr, "%12.3f %12.3f  %d scripts, %d failed, %d threads, %.3f ms wall time\n",
+            compile_ms, run_ms, nb_files, nb_failed, nb_threads < nb_files ? nb_threads : nb_files,
+            elapsed_ms(&start, &end));
+
+    for (int i = 0; i < nb_files; i++) {
+        free(batch.scripts[i].output);
+        free(batch.scripts[i].errors);
+    }
+    free(batch.scripts);
+    return nb_failed;
+}
+
+void destroy_batch_files(char **file_names, const int nb_files) {
+    for (int i = 0; i < nb_files; i++) {
+        free(file_names[i]);
+    }
+    free(file_names);
+}
@@ -0,0 +1,376 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "program/bytecode.h"
+
+#define INIT_CAPACITY 64
+
+// Appends an instruction, returns its index
+int bc_emit(t_bytecode *bc, const int opcode, const int arg) {
+    if (bc->size >= bc->capacity) {
+        bc->capacity *= 2;
+        bc->code = realloc(bc->code, bc->capacity * sizeof(t_instr));
+    }
+    bc->code[bc->size].opcode = opcode;
+    bc->code[bc->size].arg = arg;
+    return bc->size++;
+}
+
+// Sets the target of the jump at index jump_index to the next instruction
+void bc_patch_jump(t_bytecode *bc, const int jump_index) {
+    bc->code[jump_index].arg = bc->size;
+}
+
+// Copies the string into the string pool, returns its offset
+int bc_add_string(t_bytecode *bc, const char *string) {
+    const int len = (int) strlen(string) + 1;
+    while (bc->strings_size + len > bc->strings_capacity) {
+        bc->strings_capacity *= 2;
+        bc->strings = realloc(bc->strings, bc->strings_capacity);
+    }
+    const int offset = bc->strings_size;
+    memcpy(bc->strings + offset, string, len);
+    bc->strings_size += len;
+    return offset;
+}
+
+// Adds the division by the constant to the division table, returns its index
+int bc_add_div(t_bytecode *bc, const t_div_const *div) {
+    if (bc->nb_divs >= bc->divs_capacity) {
+        bc->divs_capacity *= 2;
+        bc->divs = realloc(bc->divs, bc->divs_capacity * sizeof(t_div_const));
+    }
+    bc->divs[bc->nb_divs] = *div;
+    return bc->nb_divs++;
+}
+
+// Emits the instructions pushing the value of the expression on the stack
+// The depth of the stack is followed as eval_rpn() does: where it would report a malformed expression, an OP_ERROR
+// with its diagnostic replaces the instruction, so the VM never reads an empty stack
+void bc_compile_expr(t_bytecode *bc, const t_expr_rpn *expr_rpn) {
+    int depth = 0;
+    bool failed = false;    // the instructions after an OP_ERROR are never run
+    for (int i = 0; i < expr_rpn->size; i++) {
+        const t_rpn_instr *instr = &expr_rpn->code[i];
+        switch (instr->opcode) {
+            case RPN_CONST:
+                bc_emit(bc, OP_PUSH_CONST, instr->arg.val);
+                depth++;
+                break;
+            case RPN_VAR:
+                bc_emit(bc, OP_PUSH_VAR, instr->arg.slot);
+                depth++;
+                break;
+            case RPN_OP:
+                if (!failed && depth < (instr->arg.op == NOT ? 1 : 2)) {
+                    bc_emit(bc, OP_ERROR, bc_add_string(bc, instr->arg.op == NOT
+                                                            ? "eval_rpn: NOT case -> malformed rpn expression"
+                                                            : "eval_rpn: malformed rpn expression"));
+                    failed = true;
+                    break;
+                }
+                bc_emit(bc, OP_ADD + instr->arg.op, 0);
+                depth -= instr->arg.op != NOT;
+                break;
+            case RPN_SQUARE:
+            case RPN_CUBE:
+            case RPN_SHL:
+            case RPN_DIV_CONST:
+                // Only produced from well-formed expressions
+                if (!failed && depth < 1) {
+                    bc_emit(bc, OP_ERROR, bc_add_string(bc, "eval_rpn: malformed rpn expression"));
+                    failed = true;
+                } else if (instr->opcode == RPN_SHL) {
+                    bc_emit(bc, OP_SHL, instr->arg.shift);
+                } else if (instr->opcode == RPN_DIV_CONST) {
+                    bc_emit(bc, OP_DIV_CONST, bc_add_div(bc, &instr->arg.div));
+                } else {
+                    bc_emit(bc, OP_SQUARE + (instr->opcode - RPN_SQUARE), 0);
+                }
+                break;
+            // One instruction per instruction of the expression: the target follows the & or | skipped to
+            // eval_rpn() does not jump on an empty stack: the jump goes to the next instruction
+            case RPN_AND_JUMP:
+            case RPN_OR_JUMP:
+                if (!failed && depth < 1)
+                    bc_emit(bc, OP_JUMP, bc->size + 1);
+                else
+                    bc_emit(bc, instr->opcode == RPN_AND_JUMP ? OP_AND_JUMP : OP_OR_JUMP,
+                            bc->size + instr->arg.skip + 1);
+                break;
+        }
+    }
+    if (!failed && depth < 1)
+        bc_emit(bc, OP_ERROR, bc_add_string(bc, "eval_rpn: not result get from eval\n"));
+    if (expr_rpn->max_depth > bc->max_stack)
+        bc->max_stack = expr_rpn->max_depth;
+}
+
+void bc_compile_statements(t_bytecode *bc, const t_ast *prog) {
+    for (; prog != NULL; prog = prog->next) {
+        switch (prog->command) {
+            case Assignment: {
+                const t_assignment_statement *st = &prog->statement.assignment_st;
+                bc_compile_expr(bc, &st->expr);
+                bc_emit(bc, OP_STORE_VAR, (unsigned char)st->var - 'a');
+                break;
+            }
+            case Print: {
+                const t_print_statement *st = &prog->statement.print_st;
+                if (st->expr_type == RPN) {
+                    bc_compile_expr(bc, &st->expr);
+                    bc_emit(bc, OP_PRINT, 0);
+                } else {
+                    bc_emit(bc, OP_PRINT_STR, bc_add_string(bc, eval_string_expr(&st->string)));
+                }
+                break;
+            }
+            case Return: {
+                bc_compile_expr(bc, &prog->statement.return_st.expr);
+                bc_emit(bc, OP_RETURN, 0);
+                break;
+            }
+            case If: {
+                const t_if_statement *st = &prog->statement.if_st;
+                bc_compile_expr(bc, &st->cond);
+                const int jump_else = bc_emit(bc, OP_JUMP_IF_FALSE, 0);
+                bc_compile_statements(bc, st->if_true);
+                if (st->if_false != NULL) {
+                    const int jump_end = bc_emit(bc, OP_JUMP, 0);
+                    bc_patch_jump(bc, jump_else);
+                    bc_compile_statements(bc, st->if_false);
+                    bc_patch_jump(bc, jump_end);
+                } else {
+                    bc_patch_jump(bc, jump_else);
+                }
+                break;
+            }
+            case While: {
+                const t_while_statement *st = &prog->statement.while_st;
+                const int loop_start = bc->size;
+                bc_compile_expr(bc, &st->cond);
+                const int jump_end = bc_emit(bc, OP_JUMP_IF_FALSE, 0);
+                bc_compile_statements(bc, st->block);
+                bc_emit(bc, OP_JUMP, loop_start);
+                bc_patch_jump(bc, jump_end);
+                break;
+            }
+            case For: {
+                const t_for_statement *st = &prog->statement.for_st;
+                const char var = st->init_type == VAR ? st->init.var : st->init.assignment.var;
+                if (st->init_type == ASSIGNMENT) {
+                    bc_compile_expr(bc, &st->init.assignment.expr);
+                    bc_emit(bc, OP_STORE_VAR, (unsigned char)var - 'a');
+                }
+                const int loop_start = bc->size;
+                bc_compile_expr(bc, &st->cond);
+                const int jump_end = bc_emit(bc, OP_JUMP_IF_FALSE, 0);
+                bc_compile_statements(bc, st->block);
+                bc_compile_expr(bc, &st->expr);
+                bc_emit(bc, OP_STORE_VAR, (unsigned char)var - 'a');
+                bc_emit(bc, OP_JUMP, loop_start);
+                bc_patch_jump(bc, jump_end);
+                break;
+            }
+        }
+    }
+}
+
+t_bytecode compile_bytecode(const t_ast *prog) {
+    t_bytecode bc;
+    bc.code = malloc(INIT_CAPACITY * sizeof(t_instr));
+    bc.size = 0;
+    bc.capacity = INIT_CAPACITY;
+    bc.strings = malloc(INIT_CAPACITY);
+    bc.strings_size = 0;
+    bc.strings_capacity = INIT_CAPACITY;
+    bc.divs = malloc(INIT_CAPACITY * sizeof(t_div_const));
+    bc.nb_divs = 0;
+    bc.divs_capacity = INIT_CAPACITY;
+    bc.max_stack = 0;
+
+    bc_compile_statements(&bc, prog);
+    bc_emit(&bc, OP_HALT, 0);
+    return bc;
+}
+
+// Reaches the instruction at index with a stack of depth values: queued the first time, checked afterwards
+// Returns false if there is no such instruction or if it was already reached with another depth
+bool bc_reach(const t_bytecode *bc, int *depth, int *pending, int *nb_pending, const int index, const int d) {
+    if (index < 0 || index >= bc->size)
+        return false;
+    if (depth[index] < 0) {
+        depth[index] = d;
+        pending[(*nb_pending)++] = index;
+    }
+    return depth[index] == d;
+}
+
+bool bc_is_valid_string(const t_bytecode *bc, const int offset) {
+    return offset >= 0 && offset < bc->strings_size;
+}
+
+// Returns true if the entry of the division table is the one div_const_of() gives for its divisor
+bool bc_is_valid_div(const t_div_const *div) {
+    if (div->divisor == 0 || div->divisor == 1 || div->divisor == -1 || div->divisor == INT_MIN)
+        return false;
+    const t_div_const expected = div_const_of(div->divisor);
+    return div->magic == expected.magic && div->shift == expected.shift;
+}
+
+bool is_valid_bytecode(const t_bytecode *bc) {
+    if (bc->size <= 0 || bc->max_stack < 0 || bc->strings_size < 0 || bc->nb_divs < 0
+        || (bc->strings_size > 0 && bc->strings[bc->strings_size - 1] != '\0'))
+        return false;
+    for (int i = 0; i < bc->nb_divs; i++)
+        if (!bc_is_valid_div(&bc->divs[i]))
+            return false;
+    int *depth = malloc(bc->size * sizeof(int));
+    int *pending = malloc(bc->size * sizeof(int));
+    for (int i = 0; i < bc->size; i++)
+        depth[i] = -1;
+    int nb_pending = 0;
+    bool valid = bc_reach(bc, depth, pending, &nb_pending, 0, 0);
+    while (valid && nb_pending > 0) {
+        const int i = pending[--nb_pending];
+        const t_instr *instr = &bc->code[i];
+        int d = depth[i];
+        bool falls_through = true;
+        bool jumps = false;
+        switch (instr->opcode) {
+            case OP_PUSH_CONST:
+                d++;
+                break;
+            case OP_PUSH_VAR:
+                valid = instr->arg >= 0 && instr->arg < NB_SLOTS;
+                d++;
+                break;
+            // The stack is empty after the value of an expression is used
+            case OP_STORE_VAR:
+                valid = d >= 1 && instr->arg >= 0 && instr->arg < NB_SLOTS;
+                d = 0;
+                break;
+            case OP_PRINT:
+                valid = d >= 1;
+                d = 0;
+                break;
+            case OP_JUMP_IF_FALSE:
+                valid = d >= 1;
+                d = 0;
+                jumps = true;
+                break;
+            case OP_NOT:
+            case OP_SQUARE:
+            case OP_CUBE:
+                valid = d >= 1;
+                break;
+            case OP_SHL:
+                valid = d >= 1 && instr->arg >= 0 && instr->arg < 32;
+                break;
+            case OP_DIV_CONST:
+                valid = d >= 1 && instr->arg >= 0 && instr->arg < bc->nb_divs;
+                break;
+            // The short-circuit jumps go forward, the value tested stays on the stack
+            case OP_AND_JUMP:
+            case OP_OR_JUMP:
+                valid = d >= 1 && instr->arg > i;
+                jumps = true;
+                break;
+            case OP_JUMP:
+                valid = d == 0;
+                falls_through = false;
+                jumps = true;
+                break;
+            case OP_PRINT_STR:
+                valid = d == 0 && bc_is_valid_string(bc, instr->arg);
+                break;
+            case OP_RETURN:
+                valid = d >= 1;
+                falls_through = false;
+                break;
+            case OP_HALT:
+                falls_through = false;
+                break;
+            case OP_ERROR:
+                valid = bc_is_valid_string(bc, instr->arg);
+                falls_through = false;
+                break;
+            default:
+                valid = instr->opcode >= OP_ADD && instr->opcode <= OP_XOR && d >= 2;
+                d--;
+                break;
+        }
+        valid = valid && d <= bc->max_stack;
+        if (valid && falls_through)
+            valid = bc_reach(bc, depth, pending, &nb_pending, i + 1, d);
+        if (valid && jumps)
+            valid = bc_reach(bc, depth, pending, &nb_pending, instr->arg, d);
+    }
+    free(depth);
+    free(pending);
+    return valid;
+}
+
+const char *bc_opcode_name(const int opcode) {
+    static const char *names[NB_OPCODES] = {
+        "PUSH_CONST", "PUSH_VAR", "STORE_VAR",
+        "ADD", "SUB", "MULT", "DIV", "EXP",
+        "EQUAL", "DIFF", "LESS", "GREATER", "LEQ", "GEQ",
+        "AND", "OR", "NOT", "XOR",
+        "SQUARE", "CUBE", "SHL", "DIV_CONST",
+        "JUMP", "JUMP_IF_FALSE",
+        "AND_JUMP", "OR_JUMP",
+        "PRINT", "PRINT_STR", "RETURN", "HALT", "ERROR"
+    };
+    if (opcode < 0 || opcode >= NB_OPCODES)
+        return "???";
+    return names[opcode];
+}
+
+void print_bytecode(FILE *file, const t_bytecode *bc) {
+    for (int i = 0; i < bc->size; i++) {
+        const t_instr *instr = &bc->code[i];
+        fprintf(file, "%4d  %-14s", i, bc_opcode_name(instr->opcode));
+        switch (instr->opcode) {
+            case OP_PUSH_CONST:
+            case OP_SHL:
+            case OP_JUMP:
+            case OP_JUMP_IF_FALSE:
+            case OP_AND_JUMP:
+            case OP_OR_JUMP:
+                fprintf(file, " %d", instr->arg);
+                break;
+            case OP_PUSH_VAR:
+            case OP_STORE_VAR:
+                fprintf(file, " ");
+                print_variable_file(file, instr->arg);
+                break;
+            case OP_DIV_CONST:
+                fprintf(file, " %d", bc->divs[instr->arg].divisor);
+                break;
+            case OP_PRINT_STR:
+                fprintf(file, " \"%s\"", bc->strings + instr->arg);
+                break;
+            case OP_ERROR:
+                fprintf(file, " \"%.*s\"", (int) strcspn(bc->strings + instr->arg, "\n"), bc->strings + instr->arg);
+                break;
+            default:
+                break;
+        }
+        fprintf(file, "\n");
+    }
+}
+
+void destroy_bytecode(t_bytecode *bc) {
+    free(bc->code);
+    free(bc->strings);
+    free(bc->divs);
+    bc->code = NULL;
+    bc->strings = NULL;
+    bc->divs = NULL;
+    bc->nb_divs = 0;
+    bc->size = 0;
+    bc->capacity = 0;
+}
@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "program/c_emitter.h"
+
+#define C_INDENT 4
+// Top-level statements per generated function: C compilers fail on functions of hundreds of thousands of statements
+#define C_STATEMENTS_PER_PART 1000
+
+// Runtime of the generated program, same semantics as apply_op() and fast_exp()
+// The arithmetic is done on unsigned values: signed overflow wraps as in the interpreter, without undefined behavior
+static const char *const c_runtime =
+    "static inline int op_add(int a, int b) { return (int) ((unsigned) a + (unsigned) b); }\n"
+    "static inline int op_sub(int a, int b) { return (int) ((unsigned) a - (unsigned) b); }\n"
+    "static inline int op_mult(int a, int b) { return (int) ((unsigned) a * (unsigned) b); }\n"
+    "\n"
+    "static inline int op_div(int a, int b) {\n"
+    "    if (b == 0) {\n"
+    "        fprintf(stderr, \"Division by zero\\n\");\n"
+    "        exit(EXIT_FAILURE);\n"
+    "    }\n"
+    "    return a / b;\n"
+    "}\n"
+    "\n"
+    "static inline int op_exp(int a, int b) {\n"
+    "    if (b < 3) {\n"
+    "        return b == 2 ? op_mult(a, a) : (b ? a : 1);\n"
+    "    }\n"
+    "    int acc = 1;\n"
+    "    while (b > 0) {\n"
+    "        acc = op_mult(acc, (b % 2) ? a : 1);\n"
+    "        a = op_mult(a, a);\n"
+    "        b /= 2;\n"
+    "    }\n"
+    "    return acc;\n"
+    "}\n"
+    "\n"
+    "static inline int op_xor(int a, int b) { return (a != 0) != (b != 0); }\n"
+    "\n"
+    "// Malformed expression, same diagnostic as eval_rpn()\n"
+    "static inline int expression_error(const char *message) {\n"
+    "    fprintf(stderr, \"%s\", message);\n"
+    "    exit(EXIT_FAILURE);\n"
+    "}\n";
+
+void emit_indent(FILE *file, const int depth) {
+    fprintf(file, "%*s", depth * C_INDENT, "");
+}
+
+// Writes the operand of index i of the expression, whose operands are given by the RPN tree (left, right)
+void emit_c_operand(FILE *file, const t_expr_rpn *expr, const int *left, const int *right, const int i) {
+    const t_rpn_instr *instr = &expr->code[i];
+    switch (instr->opcode) {
+        case RPN_CONST:
+            // INT_MIN has no literal
+            if (instr->arg.val == -2147483647 - 1)
+                fprintf(file, "(-2147483647 - 1)");
+            else
+                fprintf(file, instr->arg.val < 0 ? "(%d)" : "%d", instr->arg.val);
+            return;
+        case RPN_VAR:
+            print_variable_file(file, instr->arg.slot);
+            return;
+        case RPN_OP:
+            break;
+        // Specialized instructions: the operator and its constant are written back, the C compiler specializes them
+        case RPN_SQUARE:
+        case RPN_CUBE:
+            fprintf(file, "op_exp(");
+            emit_c_operand(file, expr, left, right, left[i]);
+            fprintf(file, ", %d)", instr->opcode == RPN_SQUARE ? 2 : 3);
+            return;
+        case RPN_SHL:
+            fprintf(file, "op_mult(");
+            emit_c_operand(file, expr, left, right, left[i]);
+            fprintf(file, ", %u)", 1u << instr->arg.shift);
+            return;
+        case RPN_DIV_CONST:
+            fprintf(file, "(");
+            emit_c_operand(file, expr, left, right, left[i]);
+            fprintf(file, instr->arg.div.divisor < 0 ? " / (%d))" : " / %d)", instr->arg.div.divisor);
+            return;
+        // Never operands: emit_c_expr() skips the jumps, && and || short-circuit by themselves
+        case RPN_AND_JUMP:
+        case RPN_OR_JUMP:
+            return;
+    }
+
+    static const char *const functions[] = {
+        [ADD] = "op_add", [SUB] = "op_sub", [MULT] = "op_mult", [DIV] = "op_div", [EXP] = "op_exp",
+        [XOR] = "op_xor"
+    };
+    // & and | are the operators of C, which skip the right operand as the jumps of the expression
+    static const char *const infix[] = {
+        [EQUAL] = "==", [DIFF] = "!=", [LESS] = "<", [GREATER] = ">", [LEQ] = "<=", [GEQ] = ">=",
+        [AND] = "&&", [OR] = "||"
+    };
+    const operator_type op = instr->arg.op;
+    if (op == NOT) {
+        fprintf(file, "!");
+        emit_c_operand(file, expr, left, right, left[i]);
+    } else if ((op >= EQUAL && op <= GEQ) || op == AND || op == OR) {
+        fprintf(file, "(");
+        emit_c_operand(file, expr, left, right, left[i]);
+        fprintf(file, " %s ", infix[op]);
+        emit_c_operand(file, expr, left, right, right[i]);
+        fprintf(file, ")");
+    } else {
+        fprintf(file, "%s(", functions[op]);
+        emit_c_operand(file, expr, left, right, left[i]);
+        fprintf(file, ", ");
+        emit_c_operand(file, expr, left, right, right[i]);
+        fprintf(file, ")");
+    }
+}
+
+// Writes the expression as a C expression
+// The RPN is turned into a tree first; a malformed expression stops the program where eval_rpn() would
+void emit_c_expr(FILE *file, const t_expr_rpn *expr) {
+    int *left = malloc((expr->size + 1) * sizeof(int));
+    int *right = malloc((expr->size + 1) * sizeof(int));
+    int *stack = malloc((expr->size + 1) * sizeof(int));
+    int size = 0;
+    const char *error = NULL;
+
+    for (int i = 0; i < expr->size && error == NULL; i++) {
+        const t_rpn_instr *instr = &expr->code[i];
+        if (instr->opcode == RPN_AND_JUMP || instr->opcode == RPN_OR_JUMP) {
+            continue;
+        } else if (instr->opcode == RPN_CONST || instr->opcode == RPN_VAR) {
+            stack[size++] = i;
+        } else if (instr->opcode != RPN_OP || instr->arg.op == NOT) {
+            if (size < 1) {
+                error = "eval_rpn: NOT case -> malformed rpn expression";
+                break;
+            }
+            left[i] = stack[size - 1];
+            stack[size - 1] = i;
+        } else {
+            if (size < 2) {
+                error = "eval_rpn: malformed rpn expression";
+                break;
+            }
+            right[i] = stack[--size];
+            left[i] = stack[size - 1];
+            stack[size - 1] = i;
+        }
+    }
+    if (error == NULL && size == 0)
+        error = "eval_rpn: not result get from eval\\n";
+
+    if (error != NULL) {
+        fprintf(file, "expression_error(\"%s\")", error);
+    } else {
+        // Values left under the result are evaluated, the result is the top of the stack
+        fprintf(file, size > 1 ? "(" : "");
+        for (int k = 0; k < size - 1; k++) {
+            fprintf(file, "(void) ");
+            emit_c_operand(file, expr, left, right, stack[k]);
+            fprintf(file, ", ");
+        }
+        emit_c_operand(file, expr, left, right, stack[size - 1]);
+        fprintf(file, size > 1 ? ")" : "");
+    }
+    free(left);
+    free(right);
+    free(stack);
+}
+
+// Writes the string as a C string literal
+void emit_c_string(FILE *file, const char *s) {
+    fprintf(file, "\"");
+    for (; *s != '\0'; s++) {
+        const unsigned char c = *s;
+        if (c == '"' || c == '\\')
+            fprintf(file, "\\%c", c);
+        else if (c < 32 || c >= 127)
+            fprintf(file, "\\%03o", c);
+        else
+            fprintf(file, "%c", c);
+    }
+    fprintf(file, "\"");
+}
+
+// Writes the statements of the list until end (excluded), indented by depth
+void emit_c_statements(FILE *file, const t_ast *prog, const t_ast *end, int depth);
+
+// Writes the block between braces, its closing brace indented by depth
+void emit_c_block(FILE *file, const t_ast *block, const int depth) {
+    fprintf(file, " {\n");
+    emit_c_statements(file, block, NULL, depth + 1);
+    emit_indent(file, depth);
+    fprintf(file, "}");
+}
+
+void emit_c_statements(FILE *file, const t_ast *prog, const t_ast *end, const int depth) {
+    for (; prog != end; prog = prog->next) {
+        emit_indent(file, depth);
+        switch (prog->command) {
+            case Assignment: {
+                const t_assignment_statement *st = &prog->statement.assignment_st;
+                print_variable_file(file, (unsigned char) st->var - 'a');
+                fprintf(file, " = ");
+                emit_c_expr(file, &st->expr);
+                fprintf(file, ";\n");
+                break;
+            }
+            case Print: {
+                const t_print_statement *st = &prog->statement.print_st;
+                if (st->expr_type == RPN) {
+                    fprintf(file, "printf(\"%%d\\n\", ");
+                    emit_c_expr(file, &st->expr);
+                } else {
+                    fprintf(file, "printf(\"%%s\\n\", ");
+                    emit_c_string(file, eval_string_expr(&st->string));
+                }
+                fprintf(file, ");\n");
+                break;
+            }
+            case Return: {
+                fprintf(file, "printf(\"-> %%d\\n\", ");
+                emit_c_expr(file, &prog->statement.return_st.expr);
+                fprintf(file, ");\n");
+                emit_indent(file, depth);
+                fprintf(file, "return 1;\n");
+                break;
+            }
+            case If: {
+                const t_if_statement *st = &prog->statement.if_st;
+                fprintf(file, "if (");
+                emit_c_expr(file, &st->cond);
+                fprintf(file, ")");
+                emit_c_block(file, st->if_true, depth);
+                if (st->if_false != NULL) {
+                    fprintf(file, " else");
+                    emit_c_block(file, st->if_false, depth);
+                }
+                fprintf(file, "\n");
+                break;
+            }
+            case While: {
+                const t_while_statement *st = &prog->statement.while_st;
+                fprintf(file, "while (");
+                emit_c_expr(file, &st->cond);
+                fprintf(file, ")");
+                emit_c_block(file, st->block, depth);
+                fprintf(file, "\n");
+                break;
+            }
+            case For: {
+                // Same order as run(): the initialization, then the condition, the block and the step
+                const t_for_statement *st = &prog->statement.for_st;
+                const char var = st->init_type == VAR ? st->init.var : st->init.assignment.var;
+                fprintf(file, "for (");
+                if (st->init_type == ASSIGNMENT) {
+                    fprintf(file, "%c = ", var);
+                    emit_c_expr(file, &st->init.assignment.expr);
+                }
+                fprintf(file, "; ");
+                emit_c_expr(file, &st->cond);
+                fprintf(file, "; %c = ", var);
+                emit_c_expr(file, &st->expr);
+                fprintf(file, ")");
+                emit_c_block(file, st->block, depth);
+                fprintf(file, "\n");
+                break;
+            }
+        }
+    }
+}
+
+// Marks the variables of the expression as used
+void mark_c_expr_vars(const t_expr_rpn *expr, bool used[NB_SLOTS]) {
+    for (int i = 0; i < expr->size; i++) {
+        if (expr->code[i].opcode == RPN_VAR)
+            used[expr->code[i].arg.slot] = true;
+    }
+}
+
+void mark_c_vars(const t_ast *prog, bool used[NB_SLOTS]) {
+    for (; prog != NULL; prog = prog->next) {
+        switch (prog->command) {
+            case Assignment:
+                used[(unsigned char) prog->statement.assignment_st.var - 'a'] = true;
+                mark_c_expr_vars(&prog->statement.assignment_st.expr, used);
+                break;
+            case Print:
+                if (prog->statement.print_st.expr_type == RPN)
+                    mark_c_expr_vars(&prog->statement.print_st.expr, used);
+                break;
+            case Return:
+                mark_c_expr_vars(&prog->statement.return_st.expr, used);
+                break;
+            case If:
+                mark_c_expr_vars(&prog->statement.if_st.cond, used);
+                mark_c_vars(prog->statement.if_st.if_true, used);
+                mark_c_vars(prog->statement.if_st.if_false, used);
+                break;
+            case While:
+                mark_c_expr_vars(&prog->statement.while_st.cond, used);
+                mark_c_vars(prog->statement.while_st.block, used);
+                break;
+            case For: {
+                const t_for_statement *st = &prog->statement.for_st;
+                const char var = st->init_type == VAR ? st->init.var : st->init.assignment.var;
+                used[(unsigned char) var - 'a'] = true;
+                if (st->init_type == ASSIGNMENT)
+                    mark_c_expr_vars(&st->init.assignment.expr, used);
+                mark_c_expr_vars(&st->cond, used);
+                mark_c_expr_vars(&st->expr, used);
+                mark_c_vars(st->block, used);
+                break;
+            }
+        }
+    }
+}
+
+void emit_c_program(const t_ast *prog, const char *source_file_name, FILE *file) {
+    fprintf(file, "// Generated from %s by compiler_proj --emit-c\n", source_file_name);
+    fprintf(file, "#include <stdio.h>\n#include <stdlib.h>\n\n%s\n", c_runtime);
+
+    bool used[NB_SLOTS] = { false };
+    mark_c_vars(prog, used);
+
+    // The top-level statements are split in parts, one function each: the variables are int locals of the
+    // function, loaded from vars at its start and stored back at its end
+    // A part returns 1 if a return statement was reached
+    int nb_parts = 0;
+    do {
+        const t_ast *end = prog;
+        for (int i = 0; i < C_STATEMENTS_PER_PART && end != NULL; i++) {
+            end = end->next;
+        }
+        fprintf(file, "static int part_%d(int vars[%d]) {\n", nb_parts, NB_SLOTS);
+        for (int i = 0; i < NB_SLOTS; i++) {
+            if (used[i]) {
+                fprintf(file, "%*sint ", C_INDENT, "");
+                print_variable_file(file, i);
+                fprintf(file, " = vars[%d];\n", i);
+            }
+        }
+        emit_c_statements(file, prog, end, 1);
+        for (int i = 0; i < NB_SLOTS; i++) {
+            if (used[i]) {
+                fprintf(file, "%*svars[%d] = ", C_INDENT, "", i);
+                print_variable_file(file, i);
+                fprintf(file, ";\n");
+            }
+        }
+        fprintf(file, "%*sreturn 0;\n}\n\n", C_INDENT, "");
+        nb_parts++;
+        prog = end;
+    } while (prog != NULL);
+
+    // Every variable starts at 0, as in run()
+    fprintf(file, "int main(void) {\n%*sint vars[%d] = { 0 };\n", C_INDENT, "", NB_SLOTS);
+    for (int k = 0; k < nb_parts; k++) {
+        fprintf(file, "%*sif (part_%d(vars))\n%*sreturn 0;\n", C_INDENT, "", k, 2 * C_INDENT, "");
+    }
+    fprintf(file, "%*sreturn 0;\n}\n", C_INDENT, "");
+}
@@ -0,0 +1,181 @@
+#include <fcntl.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "program/cache.h"
+#include "program/error.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// Start of the instructions, aligned for t_instr
+#define CACHE_CODE_OFFSET ((sizeof(t_cache_header) + sizeof(t_instr) - 1) / sizeof(t_instr) * sizeof(t_instr))
+
+uint64_t hash_bytes_from(uint64_t hash, const void *data, const size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t hash_bytes(const void *data, const size_t size) {
+    return hash_bytes_from(FNV_OFFSET_BASIS, data, size);
+}
+
+uint64_t hash_payload(const t_bytecode *bc) {
+    uint64_t hash = hash_bytes(bc->code, bc->size * sizeof(t_instr));
+    hash = hash_bytes_from(hash, bc->divs, bc->nb_divs * sizeof(t_div_const));
+    return hash_bytes_from(hash, bc->strings, bc->strings_size);
+}
+
+void get_cache_file_name(const char *source_file_name, char *cache_file_name, const size_t size) {
+    const size_t len = strlen(source_file_name);
+    const size_t base_len = len >= 5 && strcmp(source_file_name + len - 4, ".txt") == 0 ? len - 4 : len;
+    snprintf(cache_file_name, size, "%.*s.bc", (int) base_len, source_file_name);
+}
+
+// Returns true if the header describes a file of file_size bytes, written for the source s by this compiler
+bool is_valid_cache_header(const t_cache_header *header, const size_t file_size, const char *s, const size_t source_size) {
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0
+        || header->version != CACHE_VERSION || header->instr_size != sizeof(t_instr))
+        return false;
+    if (header->nb_instrs <= 0 || header->strings_size < 0 || header->nb_divs < 0 || header->max_stack < 0
+        || header->code_offset != CACHE_CODE_OFFSET
+        || header->divs_offset != header->code_offset + header->nb_instrs * sizeof(t_instr)
+        || header->strings_offset != header->divs_offset + header->nb_divs * sizeof(t_div_const)
+        || header->strings_offset + (size_t) header->strings_size != file_size)
+        return false;
+    // Stale cache: the source has changed since the file was written
+    return header->source_size == source_size && header->source_hash == hash_bytes(s, source_size);
+}
+
+t_program *load_program_cache(const char *cache_file_name, const char *s, const size_t size) {
+    const int fd = open(cache_file_name, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(t_cache_header)) {
+        close(fd);
+        return NULL;
+    }
+    const size_t file_size = st.st_size;
+    void *map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    const t_cache_header *header = map;
+    if (!is_valid_cache_header(header, file_size, s, size)) {
+        munmap(map, file_size);
+        return NULL;
+    }
+
+    // The bytecode points into the mapping: it is never written, and released with it
+    const t_bytecode bytecode = {
+        .code = (t_instr *) ((char *) map + header->code_offset), .size = header->nb_instrs, .capacity = 0,
+        .strings = (char *) map + header->strings_offset, .strings_size = header->strings_size, .strings_capacity = 0,
+        .divs = (t_div_const *) ((char *) map + header->divs_offset), .nb_divs = header->nb_divs, .divs_capacity = 0,
+        .max_stack = header->max_stack
+    };
+    if (header->payload_hash != hash_payload(&bytecode)) {
+        munmap(map, file_size);
+        return NULL;
+    }
+    // Checked once here, the VM and the JIT trust it: a file with the right hashes is not necessarily ours
+    if (!is_valid_bytecode(&bytecode)) {
+        fprintf(error_stream(), "Warning: the cache file %s holds invalid bytecode, it is rebuilt\n", cache_file_name);
+        munmap(map, file_size);
+        return NULL;
+    }
+    t_program *program = malloc(sizeof(t_program));
+    program->arena = create_arena();
+    program->ast = NULL;
+    program->source_ast = NULL;
+    memset(&program->opt_stats, 0, sizeof(program->opt_stats));
+    program->has_bytecode = true;
+    program->has_jit = false;
+    program->bytecode = bytecode;
+    program->cache_map = map;
+    program->cache_map_size = file_size;
+    return program;
+}
+
+bool save_program_cache(const char *cache_file_name, const char *s, const size_t size, t_program *program) {
+    compile_program_bytecode(program);
+    const t_bytecode *bc = &program->bytecode;
+
+    t_cache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.instr_size = sizeof(t_instr);
+    header.source_size = size;
+    header.source_hash = hash_bytes(s, header.source_size);
+    header.payload_hash = hash_payload(bc);
+    header.nb_instrs = bc->size;
+    header.strings_size = bc->strings_size;
+    header.nb_divs = bc->nb_divs;
+    header.max_stack = bc->max_stack;
+    header.code_offset = CACHE_CODE_OFFSET;
+    header.divs_offset = header.code_offset + bc->size * sizeof(t_instr);
+    header.strings_offset = header.divs_offset + bc->nb_divs * sizeof(t_div_const);
+
+    // Written next to the cache file then renamed: a reader never sees a partial file
+    char tmp_file_name[1000];
+    snprintf(tmp_file_name, sizeof(tmp_file_name), "%s.%d.tmp", cache_file_name, (int) getpid());
+    FILE *file = fopen(tmp_file_name, "wb");
+    if (file == NULL)
+        return false;
+    static const char padding[sizeof(t_instr)] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(padding, 1, CACHE_CODE_OFFSET - sizeof(header), file) == CACHE_CODE_OFFSET - sizeof(header)
+        && fwrite(bc->code, sizeof(t_instr), bc->size, file) == (size_t) bc->size
+        && fwrite(bc->divs, sizeof(t_div_const), bc->nb_divs, file) == (size_t) bc->nb_divs
+        && fwrite(bc->strings, 1, bc->strings_size, file) == (size_t) bc->strings_size;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tmp_file_name, cache_file_name) != 0) {
+        remove(tmp_file_name);
+        return false;
+    }
+    return true;
+}
+
+t_program *compile_program_cached(const char *s, const size_t size, const char *cache_file_name, const int nb_lex_threads) {
+    t_program *program = load_program_cache(cache_file_name, s, size);
+    if (program != NULL)
+        return program;
+
+    // The diagnostics of the compilation are not stored in the cache file: they are captured to know if there are
+    // any, and a program that has some is not cached, so that every run writes them
+    char *diagnostics = NULL;
+    size_t diagnostics_size = 0;
+    FILE *const diagnostics_stream = open_memstream(&diagnostics, &diagnostics_size);
+    FILE *const caller_output = error_output;
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    error_output = diagnostics_stream;
+    error_recovery = &recovery;
+    t_program *volatile compiled = NULL;
+    const bool failed = setjmp(recovery) != 0;
+    if (!failed)
+        compiled = compile_program(s, size, nb_lex_threads);
+    error_recovery = caller_recovery;
+    error_output = caller_output;
+    fclose(diagnostics_stream);
+    fwrite(diagnostics, 1, diagnostics_size, error_stream());
+    free(diagnostics);
+    if (failed)
+        program_error();
+
+    program = compiled;
+    if (diagnostics_size == 0 && !save_program_cache(cache_file_name, s, size, program))
+        fprintf(error_stream(), "Warning: cannot write the cache file %s\n", cache_file_name);
+    return program;
+}
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "program/compilation.h"
+#include "program/error.h"
+#include "program/parallel_lexer.h"
+#include "program/parser.h"
+#include "program/profile.h"
+#include "program/run.h"
+#include "program/vm.h"
+#include "program/jit.h"
+
+t_program *compile_program(const char *s, const size_t size, const int nb_lex_threads) {
+    return compile_program_with(s, size, nb_lex_threads, 0, false);
+}
+
+t_program *compile_program_inputs(const char *s, const size_t size, const int nb_lex_threads, const uint64_t inputs) {
+    return compile_program_with(s, size, nb_lex_threads, inputs, false);
+}
+
+t_program *compile_program_exported(const char *s, const size_t size, const int nb_lex_threads) {
+    return compile_program_with(s, size, nb_lex_threads, 0, true);
+}
+
+t_program *compile_program_with(const char *s, const size_t size, const int nb_lex_threads, const uint64_t inputs,
+                                const bool keep_source_ast) {
+    t_program *program = malloc(sizeof(t_program));
+    program->arena = create_arena();
+    program->has_bytecode = false;
+    program->has_jit = false;
+    program->cache_map = NULL;
+    program->cache_map_size = 0;
+
+    // If the error is recovered by the caller, the arena is released before jumping back to it
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    if (caller_recovery != NULL) {
+        if (setjmp(recovery) != 0) {
+            error_recovery = caller_recovery;
+            destroy_program(program);
+            longjmp(*caller_recovery, 1);
+        }
+        error_recovery = &recovery;
+    }
+
+    t_prog_token_list list = lex_parallel(s, size, &program->arena, nb_lex_threads);
+    program->ast = parse(&list, &program->arena);
+    ptl_destroy_list(&list);
+    // The optimization changes the AST in place: the export shows the program as it was written
+    program->source_ast = keep_source_ast ? copy_ast(program->ast, &program->arena) : NULL;
+    optimize_program(&program->ast, &program->arena, inputs, &program->opt_stats);
+
+    error_recovery = caller_recovery;
+    return program;
+}
+
+void compile_program_bytecode(t_program *program) {
+    if (!program->has_bytecode) {
+        program->bytecode = compile_bytecode(program->ast);
+        program->has_bytecode = true;
+    }
+}
+
+void run_compiled_program(t_program *program, const t_run_options *options) {
+    FILE *out = options->output != NULL ? options->output : stdout;
+    // A program loaded from its cache file only has its bytecode
+    const e_engine engine = program->ast != NULL || options->engine == ENGINE_JIT ? options->engine : ENGINE_VM;
+    switch (engine) {
+        case ENGINE_AST:
+            run(program->ast, out);
+            break;
+        case ENGINE_VM:
+            compile_program_bytecode(program);
+            run_vm(&program->bytecode, out);
+            break;
+        case ENGINE_JIT:
+            compile_program_bytecode(program);
+            if (!program->has_jit) {
+                compile_jit(&program->bytecode, &program->jit);
+                program->has_jit = true;
+            }
+            // Other architectures, or bytecode the JIT does not translate: the VM runs the program
+            if (program->jit.code != NULL)
+                run_jit(&program->jit, out);
+            else
+                run_vm(&program->bytecode, out);
+            break;
+    }
+}
+
+// Output of one execution of the differential test
+typedef struct {
+    char *output;
+    size_t output_size;
+    char *errors;
+    size_t errors_size;
+    bool error;
+} t_check_run;
+
+void check_run(t_program *program, const t_run_options *options, t_check_run *result) {
+    t_run_options run_options = *options;
+    run_options.output = open_memstream(&result->output, &result->output_size);
+    FILE *const errors = open_memstream(&result->errors, &result->errors_size);
+
+    FILE *const caller_output = error_output;
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    error_output = errors;
+    error_recovery = &recovery;
+    result->error = false;
+    if (setjmp(recovery) == 0)
+        run_compiled_program(program, &run_options);
+    else
+        result->error = true;
+    error_recovery = caller_recovery;
+    error_output = caller_output;
+    fclose(run_options.output);
+    fclose(errors);
+}
+
+bool check_compiled_program(t_program *program, const t_run_options *options) {
+    t_run_options reference_options = *options;
+    reference_options.engine = ENGINE_AST;
+    t_check_run reference;
+    t_check_run tested;
+    check_run(program, &reference_options, &reference);
+    check_run(program, options, &tested);
+
+    FILE *out = options->output != NULL ? options->output : stdout;
+    fwrite(tested.output, 1, tested.output_size, out);
+    fwrite(tested.errors, 1, tested.errors_size, stderr);
+
+    const bool same_output = reference.output_size == tested.output_size
+                          && memcmp(reference.output, tested.output, tested.output_size) == 0;
+    const bool same_errors = reference.error == tested.error && reference.errors_size == tested.errors_size
+                          && memcmp(reference.errors, tested.errors, tested.errors_size) == 0;
+    if (!same_output || !same_errors) {
+        size_t i = 0;
+        while (i < reference.output_size && i < tested.output_size && reference.output[i] == tested.output[i])
+            i++;
+        fprintf(stderr, "Check failed: the engine differs from the AST walker");
+        if (!same_output)
+            fprintf(stderr, " after %zu bytes of output", i);
+        if (!same_errors)
+            fprintf(stderr, ", errors: \"%.*s\" instead of \"%.*s\"", (int) tested.errors_size, tested.errors,
+                    (int) reference.errors_size, reference.errors);
+        fprintf(stderr, "\n");
+    }
+
+    free(reference.output);
+    free(reference.errors);
+    free(tested.output);
+    free(tested.errors);
+    // An error stops the program as it does without the test
+    if (tested.error)
+        program_error();
+    return same_output && same_errors;
+}
+
+// Writes in file_name the name of the source file, its extension replaced by extension
+void get_output_file_name(const char *source_file_name, const char *extension, char *file_name, const size_t size) {
+    const size_t len = strlen(source_file_name);
+    const size_t base_len = len >= 5 && source_file_name[len - 4] == '.' ? len - 4 : len;
+    snprintf(file_name, size, "%.*s%s", (int) base_len, source_file_name, extension);
+}
+
+void export_compiled_program(const t_program *program, const char *source_file_name) {
+    char file_name[1000];
+    get_output_file_name(source_file_name, ".mmd", file_name, sizeof(file_name));
+    print_ast(program->source_ast != NULL ? program->source_ast : program->ast, file_name);
+}
+
+void profile_compiled_program(t_program *program, const t_run_options *options, const char *source_file_name) {
+    t_run_options run_options = *options;
+    run_options.engine = ENGINE_AST;
+    t_profile profile;
+    init_profile(&profile, program->ast);
+
+    // The profile of a program stopped by an error is written too
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    error_recovery = &recovery;
+    run_profile = &profile;
+    const bool error = setjmp(recovery) != 0;
+    if (!error)
+        run_compiled_program(program, &run_options);
+    run_profile = NULL;
+    error_recovery = caller_recovery;
+    finish_profile(&profile);
+
+    char file_name[1000];
+    get_output_file_name(source_file_name, ".profile.txt", file_name, sizeof(file_name));
+    FILE *report = fopen(file_name, "w");
+    if (report == NULL) {
+        fprintf(stderr, "Error: cannot write %s\n", file_name);
+    } else {
+        print_profile_report(report, &profile);
+        fclose(report);
+    }
+    get_output_file_name(source_file_name, ".profile.mmd", file_name, sizeof(file_name));
+    print_ast_profile(program->ast, &profile, file_name);
+    get_output_file_name(source_file_name, ".profile.*", file_name, sizeof(file_name));
+    fflush(run_options.output != NULL ? run_options.output : stdout);
+    fprintf(stderr, "Profile: %d statements, %llu %s, written in %s\n", profile.nb_nodes,
+            (unsigned long long) profile.total_ticks, profile_tick_unit, file_name);
+    destroy_profile(&profile);
+    if (error)
+        program_error();
+}
+
+void destroy_program(t_program *program) {
+    if (program == NULL)
+        return;
+    if (program->cache_map != NULL)
+        munmap(program->cache_map, program->cache_map_size);
+    else if (program->has_bytecode)
+        destroy_bytecode(&program->bytecode);
+    if (program->has_jit)
+        destroy_jit(&program->jit);
+    destroy_arena(&program->arena);
+    free(program);
+}
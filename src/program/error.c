@@ -0,0 +1,16 @@
+#include <stdlib.h>
+
+#include "program/error.h"
+
+_Thread_local jmp_buf *error_recovery = NULL;
+_Thread_local FILE *error_output = NULL;
+
+FILE *error_stream() {
+    return error_output != NULL ? error_output : stderr;
+}
+
+void program_error() {
+    if (error_recovery != NULL)
+        longjmp(*error_recovery, 1);
+    exit(EXIT_FAILURE);
+}
@@ -0,0 +1,490 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "program/jit.h"
+#include "program/error.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+// Signature of the generated code
+typedef void (*t_jit_function)(int *var_value, FILE *out);
+
+#ifdef JIT_X86_64
+
+// Runtime called by the generated code
+
+void jit_print(FILE *out, const int value) {
+    fprintf(out, "%d\n", value);
+}
+
+void jit_print_str(FILE *out, const char *string) {
+    fprintf(out, "%s\n", string);
+}
+
+void jit_return(FILE *out, const int value) {
+    fprintf(out, "-> %d\n", value);
+}
+
+// Same diagnostics as eval_rpn() on a malformed expression
+_Noreturn void jit_expression_error(const char *message) {
+    fprintf(error_stream(), "%s", message);
+    program_error();
+}
+
+_Noreturn void jit_division_by_zero() {
+    fprintf(error_stream(), "Division by zero\n");
+    program_error();
+}
+
+// Machine code being generated
+typedef struct {
+    unsigned char *data;
+    int size;
+    int capacity;
+} t_code_buffer;
+
+// Jump whose 32-bit displacement is written once every instruction has its address
+typedef struct {
+    int pos;        // position of the displacement in the code
+    int target;     // index of the target instruction, -1 for the division by zero stub
+} t_jit_patch;
+
+void emit_bytes(t_code_buffer *buf, const void *bytes, const int size) {
+    while (buf->size + size > buf->capacity) {
+        buf->capacity = buf->capacity == 0 ? 4096 : 2 * buf->capacity;
+        buf->data = realloc(buf->data, buf->capacity);
+    }
+    memcpy(buf->data + buf->size, bytes, size);
+    buf->size += size;
+}
+
+#define EMIT(buf, ...) do {                                         \
+        const unsigned char bytes_[] = { __VA_ARGS__ };             \
+        emit_bytes(buf, bytes_, sizeof(bytes_));                    \
+    } while (0)
+
+void emit_imm32(t_code_buffer *buf, const int32_t value) {
+    emit_bytes(buf, &value, 4);
+}
+
+// mov rax, address; call rax
+void emit_call(t_code_buffer *buf, const void *function) {
+    const uint64_t address = (uint64_t) (uintptr_t) function;
+    EMIT(buf, 0x48, 0xB8);
+    emit_bytes(buf, &address, 8);
+    EMIT(buf, 0xFF, 0xD0);
+}
+
+// mov between eax and the variable in slot (opcode 0x8B loads it, 0x89 stores it), addressed from r12
+// The slots of the temporaries are too far for an 8-bit displacement
+void emit_var_access(t_code_buffer *buf, const unsigned char opcode, const int slot) {
+    if (4 * slot <= 127) {
+        EMIT(buf, 0x41, opcode, 0x44, 0x24, 4 * slot);
+    } else {
+        EMIT(buf, 0x41, opcode, 0x84, 0x24);
+        emit_imm32(buf, 4 * slot);
+    }
+}
+
+// Short conditional jump (opcode 0x70 + cc) to a label patched later, returns the position of its displacement
+int emit_jcc8(t_code_buffer *buf, const unsigned char cc) {
+    EMIT(buf, 0x70 + cc, 0);
+    return buf->size - 1;
+}
+
+int emit_jmp8(t_code_buffer *buf) {
+    EMIT(buf, 0xEB, 0);
+    return buf->size - 1;
+}
+
+// The short jump at pos lands on the next byte emitted
+void patch_jump8(t_code_buffer *buf, const int pos) {
+    buf->data[pos] = (unsigned char) (buf->size - (pos + 1));
+}
+
+#define CC_E  0x4
+#define CC_NE 0x5
+#define CC_L  0xC
+#define CC_GE 0xD
+#define CC_LE 0xE
+#define CC_G  0xF
+
+// Call to the runtime that stops the program on a malformed expression
+void emit_expression_error(t_code_buffer *buf, const char *message) {
+    const uint64_t address = (uint64_t) (uintptr_t) message;
+    EMIT(buf, 0x48, 0x83, 0xE4, 0xF0);              // and rsp, -16
+    EMIT(buf, 0x48, 0xBF);                          // mov rdi, imm64
+    emit_bytes(buf, &address, 8);
+    emit_call(buf, jit_expression_error);
+}
+
+// setcc al; movzx eax, al
+void emit_setcc(t_code_buffer *buf, const unsigned char cc) {
+    EMIT(buf, 0x0F, 0x90 + cc, 0xC0, 0x0F, 0xB6, 0xC0);
+}
+
+// b in eax, a in ecx: a ^ b in eax, same result as fast_exp()
+void emit_exp(t_code_buffer *buf) {
+    EMIT(buf, 0x83, 0xF8, 0x02);                    // cmp eax, 2
+    const int to_loop = emit_jcc8(buf, CC_G);
+    const int to_square = emit_jcc8(buf, CC_E);
+    EMIT(buf, 0x85, 0xC0);                          // test eax, eax
+    const int to_one = emit_jcc8(buf, CC_E);
+    EMIT(buf, 0x89, 0xC8);                          // mov eax, ecx (b == 1 or b < 0)
+    const int end_a = emit_jmp8(buf);
+    patch_jump8(buf, to_one);
+    EMIT(buf, 0xB8, 1, 0, 0, 0);                    // mov eax, 1
+    const int end_one = emit_jmp8(buf);
+    patch_jump8(buf, to_square);
+    EMIT(buf, 0x0F, 0xAF, 0xC9);                    // imul ecx, ecx
+    EMIT(buf, 0x89, 0xC8);                          // mov eax, ecx
+    const int end_square = emit_jmp8(buf);
+
+    // Square and multiply, b > 2
+    patch_jump8(buf, to_loop);
+    EMIT(buf, 0xBA, 1, 0, 0, 0);                    // mov edx, 1
+    const int loop = buf->size;
+    EMIT(buf, 0xA8, 0x01);                          // test al, 1
+    const int skip = emit_jcc8(buf, CC_E);
+    EMIT(buf, 0x0F, 0xAF, 0xD1);                    // imul edx, ecx
+    patch_jump8(buf, skip);
+    EMIT(buf, 0x0F, 0xAF, 0xC9);                    // imul ecx, ecx
+    EMIT(buf, 0xD1, 0xE8);                          // shr eax, 1
+    EMIT(buf, 0x70 + CC_NE, (unsigned char) (loop - (buf->size + 2)));
+    EMIT(buf, 0x89, 0xD0);                          // mov eax, edx
+
+    patch_jump8(buf, end_a);
+    patch_jump8(buf, end_one);
+    patch_jump8(buf, end_square);
+}
+
+// b in eax, a in ecx: the result of the binary operator in eax
+void emit_binary_op(t_code_buffer *buf, const int opcode, t_jit_patch **patches, int *nb_patches) {
+    switch (opcode) {
+        case OP_ADD:
+            EMIT(buf, 0x01, 0xC8);                          // add eax, ecx
+            break;
+        case OP_SUB:
+            EMIT(buf, 0x29, 0xC1, 0x89, 0xC8);              // sub ecx, eax; mov eax, ecx
+            break;
+        case OP_MULT:
+            EMIT(buf, 0x0F, 0xAF, 0xC1);                    // imul eax, ecx
+            break;
+        case OP_DIV:
+            EMIT(buf, 0x85, 0xC0, 0x0F, 0x84);              // test eax, eax; jz stub
+            *patches = realloc(*patches, (*nb_patches + 1) * sizeof(t_jit_patch));
+            (*patches)[(*nb_patches)++] = (t_jit_patch) { .pos = buf->size, .target = -1 };
+            emit_imm32(buf, 0);
+            EMIT(buf, 0x91, 0x99, 0xF7, 0xF9);              // xchg eax, ecx; cdq; idiv ecx
+            break;
+        case OP_EXP:
+            emit_exp(buf);
+            break;
+        case OP_EQUAL:
+        case OP_DIFF:
+        case OP_LESS:
+        case OP_GREATER:
+        case OP_LEQ:
+        case OP_GEQ: {
+            static const unsigned char conditions[] = { CC_E, CC_NE, CC_L, CC_G, CC_LE, CC_GE };
+            EMIT(buf, 0x39, 0xC1);                          // cmp ecx, eax
+            emit_setcc(buf, conditions[opcode - OP_EQUAL]);
+            break;
+        }
+        case OP_AND:
+        case OP_XOR:
+            EMIT(buf, 0x85, 0xC9, 0x0F, 0x95, 0xC1);        // test ecx, ecx; setne cl
+            EMIT(buf, 0x85, 0xC0, 0x0F, 0x95, 0xC0);        // test eax, eax; setne al
+            if (opcode == OP_AND)
+                EMIT(buf, 0x20, 0xC8);                      // and al, cl
+            else
+                EMIT(buf, 0x30, 0xC8);                      // xor al, cl
+            EMIT(buf, 0x0F, 0xB6, 0xC0);                    // movzx eax, al
+            break;
+        case OP_OR:
+            EMIT(buf, 0x09, 0xC8);                          // or eax, ecx
+            emit_setcc(buf, CC_NE);
+            break;
+    }
+}
+
+// a in eax: the result of the specialized instruction (operator with a constant operand) in eax
+// The division by a constant is the one of the division table of the bytecode
+void emit_special_op(t_code_buffer *buf, const t_bytecode *bc, const t_instr *instr) {
+    switch (instr->opcode) {
+        case OP_SQUARE:
+            EMIT(buf, 0x0F, 0xAF, 0xC0);                    // imul eax, eax
+            break;
+        case OP_CUBE:
+            EMIT(buf, 0x89, 0xC1);                          // mov ecx, eax
+            EMIT(buf, 0x0F, 0xAF, 0xC0, 0x0F, 0xAF, 0xC1);  // imul eax, eax; imul eax, ecx
+            break;
+        case OP_SHL:
+            EMIT(buf, 0xC1, 0xE0, instr->arg);              // shl eax, k
+            break;
+        case OP_DIV_CONST: {
+            const t_div_const div = bc->divs[instr->arg];
+            if (div.magic == 0) {
+                // Negative dividends biased by 2^k - 1, then an arithmetic shift
+                EMIT(buf, 0x89, 0xC1, 0xC1, 0xF9, 0x1F);    // mov ecx, eax; sar ecx, 31
+                EMIT(buf, 0x81, 0xE1);                      // and ecx, 2^k - 1
+                emit_imm32(buf, (int32_t) ((1u << div.shift) - 1));
+                EMIT(buf, 0x01, 0xC8, 0xC1, 0xF8, div.shift); // add eax, ecx; sar eax, k
+                if (div.divisor < 0)
+                    EMIT(buf, 0xF7, 0xD8);                  // neg eax
+                break;
+            }
+            EMIT(buf, 0x89, 0xC1, 0xBA);                    // mov ecx, eax; mov edx, magic
+            emit_imm32(buf, div.magic);
+            EMIT(buf, 0xF7, 0xEA, 0x89, 0xD0);              // imul edx; mov eax, edx
+            if (div.divisor > 0 && div.magic < 0)
+                EMIT(buf, 0x01, 0xC8);                      // add eax, ecx
+            else if (div.divisor < 0 && div.magic > 0)
+                EMIT(buf, 0x29, 0xC8);                      // sub eax, ecx
+            if (div.shift > 0)
+                EMIT(buf, 0xC1, 0xF8, div.shift);           // sar eax, s
+            EMIT(buf, 0x89, 0xC1, 0xC1, 0xE9, 0x1F);        // mov ecx, eax; shr ecx, 31
+            EMIT(buf, 0x01, 0xC8);                          // add eax, ecx
+            break;
+        }
+    }
+}
+
+// Translates the instructions; the depth of the expression stack is known at each instruction:
+// the top is in eax, the values below it are pushed on the machine stack
+// A malformed expression stops the program when it is evaluated, as in eval_rpn()
+// A short-circuit jump leaves the stack as deep as its operator does: the depth is the same on both paths
+// Returns false on bytecode the translation does not handle (a jump outside of the code, a slot outside of
+// the variable table, a specialized instruction the optimizer does not produce)
+bool jit_translate(const t_bytecode *bc, t_code_buffer *buf, int *addresses, t_jit_patch **patches, int *nb_patches) {
+    // push rbp; mov rbp, rsp; push r12; push r13; mov r12, rdi; mov r13, rsi
+    // 4 words pushed with the return address: the machine stack is aligned on 16 bytes at depth 0
+    EMIT(buf, 0x55, 0x48, 0x89, 0xE5, 0x41, 0x54, 0x41, 0x55, 0x49, 0x89, 0xFC, 0x49, 0x89, 0xF5);
+    const unsigned char epilogue[] = { 0x48, 0x8D, 0x65, 0xF0, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0xC3 };
+
+    int depth = 0;
+    bool unreachable = false;   // the expression being translated stops the program
+    for (int i = 0; i < bc->size; i++) {
+        const t_instr *instr = &bc->code[i];
+        addresses[i] = buf->size;
+        if ((instr->opcode == OP_JUMP || instr->opcode == OP_JUMP_IF_FALSE) && (instr->arg < 0 || instr->arg >= bc->size))
+            return false;
+        // The short-circuit jumps go forward, to the end of their operator
+        if ((instr->opcode == OP_AND_JUMP || instr->opcode == OP_OR_JUMP) && (instr->arg <= i || instr->arg >= bc->size))
+            return false;
+        if ((instr->opcode == OP_PUSH_VAR || instr->opcode == OP_STORE_VAR) && (instr->arg < 0 || instr->arg >= NB_SLOTS))
+            return false;
+        if ((instr->opcode == OP_SHL && (instr->arg < 1 || instr->arg > 30))
+            || (instr->opcode == OP_DIV_CONST && (instr->arg < 0 || instr->arg >= bc->nb_divs)))
+            return false;
+
+        // The value of an expression is used by one instruction, then the stack is empty: jumps only happen there
+        const bool uses_value = instr->opcode == OP_STORE_VAR || instr->opcode == OP_PRINT
+                             || instr->opcode == OP_RETURN || instr->opcode == OP_JUMP_IF_FALSE;
+        if (unreachable) {
+            if (uses_value) {
+                unreachable = false;
+                depth = 0;
+            }
+            continue;
+        }
+        if (uses_value && depth == 0) {
+            emit_expression_error(buf, "eval_rpn: not result get from eval\n");
+            depth = 0;
+            continue;
+        }
+        // Values left under the result are dropped, the result is the top of the stack
+        if (uses_value && depth > 1) {
+            EMIT(buf, 0x48, 0x8D, 0xA4, 0x24);              // lea rsp, [rsp + 8 * (depth - 1)]
+            emit_imm32(buf, 8 * (depth - 1));
+            depth = 1;
+        }
+        if ((instr->opcode == OP_JUMP || instr->opcode == OP_PRINT_STR || instr->opcode == OP_HALT) && depth != 0)
+            return false;
+
+        switch (instr->opcode) {
+            case OP_PUSH_CONST:
+                if (depth++ > 0)
+                    EMIT(buf, 0x50);                        // push rax
+                EMIT(buf, 0xB8);                            // mov eax, imm32
+                emit_imm32(buf, instr->arg);
+                break;
+            case OP_PUSH_VAR:
+                if (depth++ > 0)
+                    EMIT(buf, 0x50);                        // push rax
+                emit_var_access(buf, 0x8B, instr->arg);     // mov eax, [r12 + 4 * var]
+                break;
+            case OP_STORE_VAR:
+                emit_var_access(buf, 0x89, instr->arg);     // mov [r12 + 4 * var], eax
+                depth--;
+                break;
+            case OP_NOT:
+                if (depth < 1) {
+                    emit_expression_error(buf, "eval_rpn: NOT case -> malformed rpn expression");
+                    unreachable = true;
+                    break;
+                }
+                EMIT(buf, 0x85, 0xC0);                      // test eax, eax
+                emit_setcc(buf, CC_E);
+                break;
+            case OP_SQUARE:
+            case OP_CUBE:
+            case OP_SHL:
+            case OP_DIV_CONST:
+                // Only produced by the optimizer, from well-formed expressions
+                if (depth < 1)
+                    return false;
+                emit_special_op(buf, bc, instr);
+                break;
+            case OP_JUMP:
+            case OP_JUMP_IF_FALSE:
+                if (instr->opcode == OP_JUMP) {
+                    EMIT(buf, 0xE9);                        // jmp rel32
+                } else {
+                    EMIT(buf, 0x85, 0xC0, 0x0F, 0x84);      // test eax, eax; jz rel32
+                    depth--;
+                }
+                *patches = realloc(*patches, (*nb_patches + 1) * sizeof(t_jit_patch));
+                (*patches)[(*nb_patches)++] = (t_jit_patch) { .pos = buf->size, .target = instr->arg };
+                emit_imm32(buf, 0);
+                break;
+            case OP_AND_JUMP:
+            case OP_OR_JUMP:
+                // Only produced from well-formed expressions
+                if (depth < 1)
+                    return false;
+                EMIT(buf, 0x85, 0xC0);                      // test eax, eax
+                if (instr->opcode == OP_AND_JUMP) {
+                    EMIT(buf, 0x0F, 0x84);                  // jz rel32 (eax stays 0)
+                } else {
+                    emit_setcc(buf, CC_NE);                 // the flags are kept: 1 in eax if it jumps
+                    EMIT(buf, 0x0F, 0x85);                  // jnz rel32
+                }
+                *patches = realloc(*patches, (*nb_patches + 1) * sizeof(t_jit_patch));
+                (*patches)[(*nb_patches)++] = (t_jit_patch) { .pos = buf->size, .target = instr->arg };
+                emit_imm32(buf, 0);
+                break;
+            case OP_PRINT:
+            case OP_RETURN:
+                EMIT(buf, 0x4C, 0x89, 0xEF, 0x89, 0xC6);    // mov rdi, r13; mov esi, eax
+                emit_call(buf, instr->opcode == OP_PRINT ? (void *) jit_print : (void *) jit_return);
+                depth--;
+                if (instr->opcode == OP_RETURN)
+                    emit_bytes(buf, epilogue, sizeof(epilogue));
+                break;
+            case OP_PRINT_STR: {
+                const uint64_t string = (uint64_t) (uintptr_t) (bc->strings + instr->arg);
+                EMIT(buf, 0x4C, 0x89, 0xEF, 0x48, 0xBE);    // mov rdi, r13; mov rsi, imm64
+                emit_bytes(buf, &string, 8);
+                emit_call(buf, jit_print_str);
+                break;
+            }
+            case OP_HALT:
+                emit_bytes(buf, epilogue, sizeof(epilogue));
+                break;
+            case OP_ERROR:
+                emit_expression_error(buf, bc->strings + instr->arg);
+                unreachable = true;
+                break;
+            default:
+                if (instr->opcode < OP_ADD || instr->opcode > OP_XOR)
+                    return false;
+                if (depth < 2) {
+                    emit_expression_error(buf, "eval_rpn: malformed rpn expression");
+                    unreachable = true;
+                    break;
+                }
+                EMIT(buf, 0x59);                            // pop rcx
+                emit_binary_op(buf, instr->opcode, patches, nb_patches);
+                depth--;
+                break;
+        }
+    }
+
+    // Division by zero stub, its address is kept after the addresses of the instructions
+    // The stack is realigned for the call, which does not return
+    addresses[bc->size] = buf->size;
+    EMIT(buf, 0x48, 0x83, 0xE4, 0xF0);                      // and rsp, -16
+    emit_call(buf, jit_division_by_zero);
+    return depth == 0;
+}
+
+bool jit_supported() {
+    return true;
+}
+
+bool compile_jit(const t_bytecode *bc, t_jit_code *jit) {
+    t_code_buffer buf = { .data = NULL, .size = 0, .capacity = 0 };
+    int *addresses = malloc((bc->size + 1) * sizeof(int));
+    t_jit_patch *patches = NULL;
+    int nb_patches = 0;
+
+    bool translated = jit_translate(bc, &buf, addresses, &patches, &nb_patches);
+    for (int i = 0; translated && i < nb_patches; i++) {
+        const int target = patches[i].target < 0 ? addresses[bc->size] : addresses[patches[i].target];
+        const int32_t displacement = target - (patches[i].pos + 4);
+        memcpy(buf.data + patches[i].pos, &displacement, 4);
+    }
+
+    // Written, then made executable: the mapping is never writable and executable at the same time
+    void *code = MAP_FAILED;
+    const size_t size = buf.size;
+    if (translated)
+        code = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code != MAP_FAILED) {
+        memcpy(code, buf.data, size);
+        if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+            munmap(code, size);
+            code = MAP_FAILED;
+        }
+    }
+    free(buf.data);
+    free(addresses);
+    free(patches);
+
+    jit->code = code == MAP_FAILED ? NULL : code;
+    jit->size = code == MAP_FAILED ? 0 : size;
+    return jit->code != NULL;
+}
+
+void destroy_jit(t_jit_code *jit) {
+    if (jit->code != NULL)
+        munmap(jit->code, jit->size);
+    jit->code = NULL;
+    jit->size = 0;
+}
+
+#else
+
+bool jit_supported() {
+    return false;
+}
+
+bool compile_jit(const t_bytecode *bc, t_jit_code *jit) {
+    (void) bc;
+    jit->code = NULL;
+    jit->size = 0;
+    return false;
+}
+
+void destroy_jit(t_jit_code *jit) {
+    jit->code = NULL;
+    jit->size = 0;
+}
+
+#endif
+
+void run_jit(const t_jit_code *jit, FILE *out) {
+    int var_value[NB_SLOTS];
+    for (int i = 0; i < NB_SLOTS; i++) {
+        var_value[i] = 0;
+    }
+    // Conversion of an object pointer to a function pointer, allowed by POSIX
+    const t_jit_function function = (t_jit_function) jit->code;
+    function(var_value, out);
+}
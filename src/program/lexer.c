@@ -1,45 +1,65 @@
 #include "program/lexical.h"
 #include "program/program.h"
 #include "program/lexer.h"
+#include "program/error.h"
+#include "expressions/simplifier.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-bool str_eq(const char* s1, const char *s2, const unsigned int length) {
-    for (unsigned int i = 0; i < length; i++) {
-        if (s1[i] == '\0' || s2[i] == '\0' || s1[i] != s2[i])
-            return false;
-    }
-    return true;
+bool is_allowed_var(const char var) {
+    return var >= 'a' && var <= 'z';
 }
 
-// Returns true if s (= *p_s) contains the keyword of type keyword_type as a prefix
+// Spelling of a keyword, and whether it is a word: a word must not be followed by a letter
+typedef struct {
+    const char *text;
+    unsigned int length;
+    bool is_word;
+} t_keyword_spelling;
+
+// Indexed by e_keyword
+static const t_keyword_spelling keyword_spellings[] = {
+    [KW_ASSIGN]     = { "=",            1,  false },
+    [KW_IF]         = { "if",           2,  true },
+    [KW_ELSE]       = { "else",         4,  true },
+    [KW_WHILE]      = { "while",        5,  true },
+    [KW_ENDBLOCK]   = { "(end-block)",  11, false },
+    [KW_RETURN]     = { "return",       6,  true },
+    [KW_PRINT]      = { "print",        5,  true },
+    [KW_FOR]        = { "for",          3,  true },
+};
+
+// Returns true if s (= *p_s) starts with a keyword
+// Every keyword has its own first character: the first character selects the only keyword to compare
 // If so, fills the token so that it is a token of type keyword
 // Moves p_s forward to skip past the keyword
-bool process_keyword(const char **p_s, const e_keyword keyword_type, t_prog_token *token) {
+bool process_keyword(const char **p_s, t_prog_token *token) {
     const char *s = *p_s;
-    const char *kw = NULL;
-    unsigned int len = 0;
-
-    switch (keyword_type) {
-        case KW_ASSIGN:     kw = "=";           len = 1;    break;
-        case KW_IF:         kw = "if";          len = 2;    break;
-        case KW_FOR:        kw = "for";         len = 3;    break;
-        case KW_ELSE:       kw = "else";        len = 4;    break;
-        case KW_WHILE:      kw = "while";       len = 5;    break;
-        case KW_ENDBLOCK:   kw = "(end-block)"; len = 11;   break;
-        case KW_RETURN:     kw = "return";      len = 6;    break;
-        case KW_PRINT:      kw = "print";       len = 5;    break;
-        default: fprintf(stderr, "process_keyword: Unrecognized keywork");
+    e_keyword keyword_type;
+    switch (s[0]) {
+        case '=':   keyword_type = KW_ASSIGN;   break;
+        case 'i':   keyword_type = KW_IF;       break;
+        case 'e':   keyword_type = KW_ELSE;     break;
+        case 'w':   keyword_type = KW_WHILE;    break;
+        case '(':   keyword_type = KW_ENDBLOCK; break;
+        case 'r':   keyword_type = KW_RETURN;   break;
+        case 'p':   keyword_type = KW_PRINT;    break;
+        case 'f':   keyword_type = KW_FOR;      break;
+        default:    return false;
     }
 
-    if (str_eq(s, kw, len)) {
-        token->token_type = PT_KEYWORD;
-        token->content.keyword = keyword_type;
-        *p_s = s + len;
-        return true;
-    }
-    return false;
+    // strncmp stops at the '\0' that ends the source
+    const t_keyword_spelling *kw = &keyword_spellings[keyword_type];
+    if (strncmp(s + 1, kw->text + 1, kw->length - 1) != 0)
+        return false;
+    if (kw->is_word && is_allowed_var(s[kw->length]))
+        return false;
+
+    token->token_type = PT_KEYWORD;
+    token->content.keyword = keyword_type;
+    *p_s = s + kw->length;
+    return true;
 }
 
 bool is_kw_await_expr(const e_keyword keyword_type) {
@@ -52,7 +72,7 @@ bool is_kw_await_expr(const e_keyword keyword_type) {
         case KW_RETURN:   return true;
         case KW_ENDBLOCK:
         case KW_ELSE: return false;
-        default: fprintf(stderr, "process_keyword: Unrecognized keywork"); return false;
+        default: fprintf(error_stream(), "process_keyword: Unrecognized keywork"); return false;
     }
 }
 
@@ -66,14 +86,10 @@ bool is_kw_await_endblock(const e_keyword keyword_type) {
         case KW_PRINT:
         case KW_RETURN:
         case KW_ENDBLOCK:   return false;
-        default: fprintf(stderr, "process_keyword: Unrecognized keywork"); return false;
+        default: fprintf(error_stream(), "process_keyword: Unrecognized keywork"); return false;
     }
 }
 
-bool is_allowed_var(const char var) {
-    return var >= 'a' && var <= 'z';
-}
-
 bool process_var(const char **p_s, t_prog_token *token) {
     const char *s = *p_s;
     if (!is_allowed_var(s[0])) return false;
@@ -83,16 +99,7 @@ bool process_var(const char **p_s, t_prog_token *token) {
     return true;
 }
 
-char** substring(const char *str, const int length) {
-    char **result = (char **)malloc(sizeof(char*));
-    char *sub = (char *)malloc(length + 1);
-    memcpy(sub, str, length);
-    sub[length] = '\0';
-    *result = sub;
-    return result;
-}
-
-bool process_expr(const char **p_s, t_prog_token *token, bool in_for) {
+bool process_expr(const char **p_s, t_prog_token *token, bool in_for, t_arena *arena) {
     int len = 0;
     const char* s = *p_s;
 
@@ -101,7 +108,7 @@ bool process_expr(const char **p_s, t_prog_token *token, bool in_for) {
         while (s[len] != '\n' && s[len] != '\0' && s[len] != '\"') len++;
         if (len == 0) return false;
         token->token_type = PT_STRING;
-        const t_expr expr = parse_expr(p_s);
+        const t_expr expr = parse_expr(p_s, arena);
         token->content.expr = expr;
     } else {
         while (s[len] != '\n' && s[len] != '\0' && s[len] != '\"' && s[len] != ';') len++;
@@ -110,138 +117,169 @@ bool process_expr(const char **p_s, t_prog_token *token, bool in_for) {
         t_expr expression;
         if (in_for) {
             while (s[len] != ';' && s[len] != ')') len--;
-            const char **sub = substring(s, len);
-            expression = parse_expr(sub);
-            free(sub);
+            const char *sub = arena_strndup(arena, s, len);
+            expression = parse_expr(&sub, arena);
             *p_s = *p_s + len;
         } else {
-            expression = parse_expr(p_s); // parse and move p_s forward
+            expression = parse_expr(p_s, arena); // parse and move p_s forward
         }
-        token->content.expr_rpn = shunting_yard(&expression);
+        token->content.expr_rpn = shunting_yard(&expression, arena);
         // precomputing
-        simplify_constant_subexpressions_rpn(&token->content.expr_rpn);
-        if (is_constant_expr_rpn(&token->content.expr_rpn)) {
-            precompute_constant_expr_rpn(&token->content.expr_rpn);
-        }
+        simplify_expr_rpn(&token->content.expr_rpn, true);
     }
     return true;
 }
 
-t_prog_token_list lex(const char *s) {
-    t_prog_token_list list = ptl_create_empty_list();
+const char *lex_range(const char *s, const char *end, t_lexer_state *state, t_arena *arena,
+                      t_prog_token_list *list, const t_line_callback on_line, void *ctx) {
 
     #define BASE_INDENT 4
-    #define NB_KEYWORDS 8
-    static constexpr e_keyword keywords[NB_KEYWORDS] = { KW_ASSIGN, KW_IF, KW_ELSE, KW_WHILE, KW_ENDBLOCK, KW_RETURN, KW_PRINT, KW_FOR};
-
-    bool await_expr = false;
-    bool await_endblock = false;
-    bool in_indent = true;
-    bool in_for = false;
-    bool skip_expr = false;
-    int nb_endblock_awaited = 0;
-    int len_indent = 0;
-    int curr_indent = 0;
-
-    while (*s != '\0' && *s != EOF) {
+
+    const char *const begin = s;
+    while ((end == NULL || s < end) && *s != '\0' && *s != EOF) {
         t_prog_token token;
-        if (in_indent && *s != ' ') {
-            in_indent = false;
+        if (on_line != NULL && (s == begin || (s[-1] == '\n' && *s != ' ' && *s != '\n' && *s != '\r'))) {
+            if (on_line(ctx, s, state, list->size))
+                break;
         }
-        if (in_indent && *s == ' ') {
-            len_indent++;
+        if (state->in_indent && *s != ' ') {
+            state->in_indent = false;
+        }
+        if (state->in_indent && *s == ' ') {
+            state->len_indent++;
         }
         if (*s == '\n') {
-            in_indent = true;
-            curr_indent = len_indent;
-            len_indent = 0;
+            state->in_indent = true;
+            state->curr_indent = state->len_indent;
+            state->len_indent = 0;
         }
-        if (skip_expr && *s == '(') {
+        if (state->skip_expr && *s == '(') {
             s++;
             continue;
         }
         if (*s == ';') {
             s++;
-            await_expr = true;
-            skip_expr = false;
+            state->await_expr = true;
+            state->skip_expr = false;
             continue;
         }
         if (*s == ' ' || *s == '\n' || *s == '\r') {
             s++;
             continue;
         }
-        if (nb_endblock_awaited > 0) {
-            await_endblock = true;
+        if (state->nb_endblock_awaited > 0) {
+            state->await_endblock = true;
         }
 
 
         // keyword
-        bool skip_endblock = !await_endblock;
+        bool skip_endblock = !state->await_endblock;
         bool is_kw = false;
         bool need_to_add_eb = false;
-        for (int i = 0; i < NB_KEYWORDS; i++) {
-            if (process_keyword(&s, keywords[i], &token)) {
-                await_expr = is_kw_await_expr(keywords[i]);
-                if (is_kw_await_endblock(keywords[i])) {
-                    need_to_add_eb = true;
-                }
-                skip_endblock = !await_endblock;
-                if (keywords[i] == KW_ELSE) {
-                    skip_endblock = true;
-                }
-                if (keywords[i] == KW_FOR) {
-                    in_for = true;
-                    skip_expr = true;
-                }
-                if (skip_expr && keywords[i] == KW_ASSIGN) {
-                    skip_expr = false;
-                }
-                is_kw = true;
-                break;
+        bool is_else = false;
+        if (process_keyword(&s, &token)) {
+            const e_keyword keyword = token.content.keyword;
+            state->await_expr = is_kw_await_expr(keyword);
+            if (is_kw_await_endblock(keyword)) {
+                need_to_add_eb = true;
+            }
+            skip_endblock = !state->await_endblock;
+            is_else = keyword == KW_ELSE;
+            if (keyword == KW_FOR) {
+                state->in_for = true;
+                state->skip_expr = true;
+            }
+            if (state->skip_expr && keyword == KW_ASSIGN) {
+                state->skip_expr = false;
             }
+            is_kw = true;
         }
-        if (len_indent < curr_indent) {
+        if (state->len_indent < state->curr_indent) {
             if (!skip_endblock) {
-                const int nb_endblock_to_add = nb_endblock_awaited - len_indent/BASE_INDENT;
+                // An else ends the block of its if itself: only the blocks nested deeper end before it
+                const int nb_endblock_to_add = state->nb_endblock_awaited - state->len_indent/BASE_INDENT - is_else;
                 for (int j = 0; j < nb_endblock_to_add; j++) {
                     t_prog_token eb_token;
                     eb_token.token_type = PT_KEYWORD;
                     eb_token.content.keyword = KW_ENDBLOCK;
-                    ptl_push_back(&list, eb_token);
-                    nb_endblock_awaited--;
-                    curr_indent -= BASE_INDENT;
+                    ptl_push_back(list, eb_token);
+                    state->nb_endblock_awaited--;
+                    state->curr_indent -= BASE_INDENT;
                 }
-                if (nb_endblock_awaited == 0) {
-                    await_endblock = false;
+                if (state->nb_endblock_awaited == 0) {
+                    state->await_endblock = false;
                 }
             }
         }
-        if (need_to_add_eb) nb_endblock_awaited++;
-        if (is_kw) { ptl_push_back(&list, token); continue; }
+        if (need_to_add_eb) state->nb_endblock_awaited++;
+        if (is_kw) { ptl_push_back(list, token); continue; }
 
-        if (await_expr && !skip_expr) {
-            if (process_expr(&s, &token, in_for)) {
-                ptl_push_back(&list, token);
-                await_expr = false;
+        if (state->await_expr && !state->skip_expr) {
+            if (process_expr(&s, &token, state->in_for, arena)) {
+                ptl_push_back(list, token);
+                state->await_expr = false;
                 // Skip to the end of the line, avoid unexpected tokens at the of the program
                 while (*s != '\n' && *s != '\0' && *s != ';') {
                     if (*s == ')') {
-                        in_for = false;
+                        state->in_for = false;
                     }
                     s++;
                 }
                 continue;
             }
-            fprintf(stderr, "Lexer error: expected expression\n");
-            exit(EXIT_FAILURE);
+            fprintf(error_stream(), "Lexer error: expected expression\n");
+            program_error();
         }
         if (process_var(&s, &token)) {
-            ptl_push_back(&list, token);
+            ptl_push_back(list, token);
             continue;
         }
         // Skip unknown characters
         s++;
     }
-    
-    return list;
+    return s;
+}
+
+t_lexer_state lexer_initial_state() {
+    t_lexer_state state;
+    state.await_expr = false;
+    state.await_endblock = false;
+    state.in_indent = true;
+    state.in_for = false;
+    state.skip_expr = false;
+    state.nb_endblock_awaited = 0;
+    state.len_indent = 0;
+    state.curr_indent = 0;
+    return state;
+}
+
+bool lexer_state_equal(const t_lexer_state *a, const t_lexer_state *b) {
+    return a->await_expr == b->await_expr && a->await_endblock == b->await_endblock
+        && a->in_indent == b->in_indent && a->in_for == b->in_for && a->skip_expr == b->skip_expr
+        && a->nb_endblock_awaited == b->nb_endblock_awaited
+        && a->len_indent == b->len_indent && a->curr_indent == b->curr_indent;
+}
+
+t_prog_token_list lex(const char *s, const size_t size, t_arena *arena) {
+    // Kept in the arena: it is still reachable if an error jumps out of lex_range
+    t_prog_token_list *const list = arena_alloc(arena, sizeof(t_prog_token_list));
+    *list = ptl_create_empty_list();
+
+    // If the error is recovered by the caller, the list is released before jumping back to it
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    if (caller_recovery != NULL) {
+        if (setjmp(recovery) != 0) {
+            error_recovery = caller_recovery;
+            ptl_destroy_list(list);
+            longjmp(*caller_recovery, 1);
+        }
+        error_recovery = &recovery;
+    }
+
+    t_lexer_state state = lexer_initial_state();
+    lex_range(s, s + size, &state, arena, list, NULL, NULL);
+
+    error_recovery = caller_recovery;
+    return *list;
 }
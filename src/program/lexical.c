@@ -3,30 +3,34 @@
 #include <stdio.h>
 
 void print_keyword(const e_keyword keyword) {
+    print_keyword_file(stdout, keyword);
+}
+
+void print_keyword_file(FILE *file, const e_keyword keyword) {
     switch (keyword) {
         case KW_ASSIGN:
-            printf("ASSIGN");
+            fprintf(file, "ASSIGN");
             break;
         case KW_IF:
-            printf("IF");
+            fprintf(file, "IF");
             break;
         case KW_ELSE:
-            printf("ELSE");
+            fprintf(file, "ELSE");
             break;
         case KW_WHILE:
-            printf("WHILE");
+            fprintf(file, "WHILE");
             break;
         case KW_PRINT:
-            printf("PRINT");
+            fprintf(file, "PRINT");
             break;
         case KW_RETURN:
-            printf("RETURN");
+            fprintf(file, "RETURN");
             break;
         case KW_ENDBLOCK:
-            printf("ENDBLOCK");
+            fprintf(file, "ENDBLOCK");
             break;
         case KW_FOR:
-            printf("FOR");
+            fprintf(file, "FOR");
             break;
     }
 }
@@ -38,7 +42,7 @@ void print_prog_token(const t_prog_token *token) {
             break;
         case PT_EXPR:
             printf("Expr(");
-            print_expr(&token->content.expr_rpn.expr);
+            print_expr_rpn(&token->content.expr_rpn);
             printf(")");
             break;
         case PT_STRING:
@@ -51,7 +55,3 @@ void print_prog_token(const t_prog_token *token) {
             break;
     }
 }
-
-void destroy_prog_token(t_prog_token *token) {
-    destroy_expr_rpn(&token->content.expr_rpn);
-}
\ No newline at end of file
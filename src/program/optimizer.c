@@ -0,0 +1,1172 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "program/optimizer.h"
+#include "expressions/simplifier.h"
+
+#define SLOT_BIT(slot) ((uint64_t) 1 << (slot))
+
+// Slot of the variable assigned by an assignment or a For loop
+int var_slot(const char var) {
+    return (unsigned char) var - 'a';
+}
+
+int for_var_slot(const t_for_statement *st) {
+    return var_slot(st->init_type == VAR ? st->init.var : st->init.assignment.var);
+}
+
+// Returns the slots assigned by the statements of the list and their nested blocks
+uint64_t written_slots(const t_ast *prog) {
+    uint64_t written = 0;
+    for (; prog != NULL; prog = prog->next) {
+        switch (prog->command) {
+            case Assignment:
+                written |= SLOT_BIT(var_slot(prog->statement.assignment_st.var));
+                break;
+            case If:
+                written |= written_slots(prog->statement.if_st.if_true) | written_slots(prog->statement.if_st.if_false);
+                break;
+            case While:
+                written |= written_slots(prog->statement.while_st.block);
+                break;
+            case For:
+                written |= SLOT_BIT(for_var_slot(&prog->statement.for_st)) | written_slots(prog->statement.for_st.block);
+                break;
+            default:
+                break;
+        }
+    }
+    return written;
+}
+
+// Returns true if the two instruction sequences compute the same value
+bool same_rpn_code(const t_rpn_instr *code1, const int size1, const t_rpn_instr *code2, const int size2) {
+    if (size1 != size2)
+        return false;
+    for (int i = 0; i < size1; i++) {
+        if (code1[i].opcode != code2[i].opcode)
+            return false;
+        switch (code1[i].opcode) {
+            case RPN_CONST:
+                if (code1[i].arg.val != code2[i].arg.val)
+                    return false;
+                break;
+            case RPN_VAR:
+                if (code1[i].arg.slot != code2[i].arg.slot)
+                    return false;
+                break;
+            case RPN_OP:
+                if (code1[i].arg.op != code2[i].arg.op)
+                    return false;
+                break;
+            case RPN_SHL:
+                if (code1[i].arg.shift != code2[i].arg.shift)
+                    return false;
+                break;
+            case RPN_DIV_CONST:
+                if (code1[i].arg.div.divisor != code2[i].arg.div.divisor)
+                    return false;
+                break;
+            case RPN_AND_JUMP:
+            case RPN_OR_JUMP:
+                if (code1[i].arg.skip != code2[i].arg.skip)
+                    return false;
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// Constant propagation and dead code elimination
+
+// Values of the slots known at a point of the program
+typedef struct {
+    uint64_t known;             // bit slot set if the value of the slot is known
+    int value[NB_SLOTS];
+} t_values;
+
+// Returns the number of statements of the list, nested blocks included
+int count_statements(const t_ast *prog) {
+    int count = 0;
+    for (; prog != NULL; prog = prog->next) {
+        count++;
+        switch (prog->command) {
+            case If:
+                count += count_statements(prog->statement.if_st.if_true) + count_statements(prog->statement.if_st.if_false);
+                break;
+            case While:
+                count += count_statements(prog->statement.while_st.block);
+                break;
+            case For:
+                count += count_statements(prog->statement.for_st.block);
+                break;
+            default:
+                break;
+        }
+    }
+    return count;
+}
+
+void copy_expr_rpn(t_expr_rpn *expr, t_arena *arena) {
+    t_rpn_instr *code = arena_alloc(arena, expr->size * sizeof(t_rpn_instr));
+    memcpy(code, expr->code, expr->size * sizeof(t_rpn_instr));
+    expr->code = code;
+}
+
+t_ast *copy_ast(const t_ast *prog, t_arena *arena) {
+    t_ast *first = NULL;
+    t_ast **link = &first;
+    for (; prog != NULL; prog = prog->next) {
+        t_ast *node = arena_alloc(arena, sizeof(t_ast));
+        *node = *prog;
+        switch (node->command) {
+            case Assignment:
+                copy_expr_rpn(&node->statement.assignment_st.expr, arena);
+                break;
+            case Return:
+                copy_expr_rpn(&node->statement.return_st.expr, arena);
+                break;
+            case Print:
+                if (node->statement.print_st.expr_type == RPN)
+                    copy_expr_rpn(&node->statement.print_st.expr, arena);
+                break;
+            case If:
+                copy_expr_rpn(&node->statement.if_st.cond, arena);
+                node->statement.if_st.if_true = copy_ast(prog->statement.if_st.if_true, arena);
+                node->statement.if_st.if_false = copy_ast(prog->statement.if_st.if_false, arena);
+                break;
+            case While:
+                copy_expr_rpn(&node->statement.while_st.cond, arena);
+                node->statement.while_st.block = copy_ast(prog->statement.while_st.block, arena);
+                break;
+            case For:
+                if (node->statement.for_st.init_type == ASSIGNMENT)
+                    copy_expr_rpn(&node->statement.for_st.init.assignment.expr, arena);
+                copy_expr_rpn(&node->statement.for_st.cond, arena);
+                copy_expr_rpn(&node->statement.for_st.expr, arena);
+                node->statement.for_st.block = copy_ast(prog->statement.for_st.block, arena);
+                break;
+        }
+        *link = node;
+        link = &node->next;
+    }
+    return first;
+}
+
+// Returns true if the evaluation of the expression never reads an empty stack and leaves one value
+bool is_well_formed_rpn(const t_expr_rpn *expr) {
+    int depth = 0;
+    for (int i = 0; i < expr->size; i++) {
+        const t_rpn_instr *instr = &expr->code[i];
+        if (instr->opcode == RPN_CONST || instr->opcode == RPN_VAR)
+            depth++;
+        else if (instr->opcode != RPN_OP || instr->arg.op == NOT) {
+            if (depth < 1)
+                return false;
+        } else if (depth-- < 2)
+            return false;
+    }
+    return depth == 1;
+}
+
+// Replaces the variables of known value by their constant, then simplifies the expression (simplify_expr_rpn())
+// An operator that would stop the program (a division by zero, INT_MIN / -1) is left to the execution: it may
+// never be evaluated. A malformed expression is left as it is
+void propagate_expr(t_expr_rpn *expr, const t_values *values, t_opt_stats *stats) {
+    if (!is_well_formed_rpn(expr))
+        return;
+    bool changed = false;
+    for (int i = 0; i < expr->size; i++) {
+        t_rpn_instr *instr = &expr->code[i];
+        if (instr->opcode == RPN_VAR && (values->known & SLOT_BIT(instr->arg.slot))) {
+            const int value = values->value[instr->arg.slot];
+            instr->opcode = RPN_CONST;
+            instr->arg.val = value;
+            stats->propagated++;
+            changed = true;
+        }
+    }
+    if (changed)
+        simplify_expr_rpn(expr, false);
+}
+
+// Returns true if the expression is a constant, its value in value
+bool is_constant_rpn(const t_expr_rpn *expr, int *value) {
+    if (expr->size != 1 || expr->code[0].opcode != RPN_CONST)
+        return false;
+    *value = expr->code[0].arg.val;
+    return true;
+}
+
+// Returns true if the expression has a constant value with the known values, without changing it
+bool constant_value(const t_expr_rpn *expr, const t_values *values, int *value) {
+    t_expr_rpn copy = *expr;
+    copy.code = malloc(expr->size * sizeof(t_rpn_instr));
+    memcpy(copy.code, expr->code, expr->size * sizeof(t_rpn_instr));
+    t_opt_stats ignored;
+    propagate_expr(&copy, values, &ignored);
+    const bool constant = is_constant_rpn(&copy, value);
+    free(copy.code);
+    return constant;
+}
+
+// The slot now holds the value of expr, known if it is a constant
+void assign_value(t_values *values, const int slot, const t_expr_rpn *expr) {
+    int value;
+    if (is_constant_rpn(expr, &value)) {
+        values->known |= SLOT_BIT(slot);
+        values->value[slot] = value;
+    } else {
+        values->known &= ~SLOT_BIT(slot);
+    }
+}
+
+// Keeps in values the values known with the same value in other: the two paths of an If join
+void join_values(t_values *values, const t_values *other) {
+    for (int slot = 0; slot < NB_SLOTS; slot++) {
+        if (!(other->known & SLOT_BIT(slot)) || other->value[slot] != values->value[slot])
+            values->known &= ~SLOT_BIT(slot);
+    }
+}
+
+// Counted loops: a loop that only assigns variables, whose values are polynomials of the iteration number and
+// whose condition compares an affine value with a constant, is replaced by the values when it exits
+// The arithmetic is modulo 2^32, as the execution: the results are the same, wraparound included
+
+// Maximum degree of the polynomials
+#define CLOSED_FORM_DEGREE 6
+
+// Polynomial of the iteration number k in the binomial basis: sum of coef[j] * C(k, j), modulo 2^32
+// The basis keeps the coefficients integers: the sum of C(m, j) for m < k is C(k, j + 1)
+typedef struct {
+    uint32_t coef[CLOSED_FORM_DEGREE + 1];
+} t_poly;
+
+// Loop evaluated in closed form: the values of the variables it assigns, as polynomials of k
+typedef struct {
+    const t_values *entry;              // values known when the loop is reached
+    uint64_t written;                   // slots assigned by the loop
+    uint64_t current;                   // slots of written whose value at this point of iteration k is known
+    t_poly value[NB_SLOTS];
+} t_counted_loop;
+
+// Assignment of the body of a counted loop, the update of a For loop being the last one
+typedef struct {
+    int slot;
+    t_expr_rpn *expr;
+} t_counted_assignment;
+
+int poly_degree(const t_poly *p) {
+    int degree = CLOSED_FORM_DEGREE;
+    while (degree >= 0 && p->coef[degree] == 0)
+        degree--;
+    return degree;
+}
+
+t_poly poly_constant(const int value) {
+    t_poly p = { .coef = { (uint32_t) value } };
+    return p;
+}
+
+// C(n, j) for small n
+uint32_t small_binomial(const int n, const int j) {
+    uint32_t c = 1;
+    for (int i = 0; i < j; i++)
+        c = c * (n - i) / (i + 1);
+    return c;
+}
+
+// Product of two polynomials: C(k, i) * C(k, j) is the sum of C(c, i) * C(i, c - j) * C(k, c) for c from
+// max(i, j) to i + j. Returns false if the degree of the product is too high
+bool poly_mult(const t_poly *a, const t_poly *b, t_poly *res) {
+    t_poly p = { .coef = { 0 } };
+    for (int i = 0; i <= CLOSED_FORM_DEGREE; i++) {
+        for (int j = 0; j <= CLOSED_FORM_DEGREE; j++) {
+            if (a->coef[i] == 0 || b->coef[j] == 0)
+                continue;
+            if (i + j > CLOSED_FORM_DEGREE)
+                return false;
+            for (int c = i > j ? i : j; c <= i + j; c++)
+                p.coef[c] += a->coef[i] * b->coef[j] * small_binomial(c, i) * small_binomial(i, c - j);
+        }
+    }
+    *res = p;
+    return true;
+}
+
+// C(k, j) modulo 2^32: the factors of j! are cancelled from the j numerators before the product
+uint32_t binomial_mod(const uint64_t k, const int j) {
+    if (k < (uint64_t) j)
+        return 0;
+    uint64_t num[CLOSED_FORM_DEGREE + 1];
+    for (int i = 0; i < j; i++)
+        num[i] = k - i;
+    for (int d = 2; d <= j; d++) {
+        uint64_t rest = d;
+        for (int i = 0; i < j && rest > 1; i++) {
+            uint64_t g = num[i], r = rest;
+            while (r != 0) {
+                const uint64_t t = g % r;
+                g = r;
+                r = t;
+            }
+            num[i] /= g;
+            rest /= g;
+        }
+    }
+    uint64_t c = 1;
+    for (int i = 0; i < j; i++)
+        c *= num[i];
+    return (uint32_t) c;
+}
+
+// Value of the polynomial at iteration k
+int poly_at(const t_poly *p, const uint64_t k) {
+    uint32_t value = 0;
+    for (int j = 0; j <= CLOSED_FORM_DEGREE; j++)
+        value += p->coef[j] * binomial_mod(k, j);
+    return (int) value;
+}
+
+// Evaluates the instructions [0, end) of the expression on polynomials, pushes the values left on stack
+// A read of self_slot whose value is not known at this point is symbolic: self receives, for each value, its
+// coefficient of the value of self_slot (v = v + step gives 1, the step being the polynomial)
+// Returns false if a value is not a polynomial of k: an operator other than +, -, * and ^ on a value that
+// depends on k, a variable whose value is unknown at this point, a product of the symbolic value
+bool poly_eval(const t_expr_rpn *expr, const int end, const t_counted_loop *loop, const int self_slot,
+               t_poly *stack, uint32_t *self, int *depth) {
+    int size = 0;
+    for (int i = 0; i < end; i++) {
+        const t_rpn_instr *instr = &expr->code[i];
+        if (instr->opcode == RPN_CONST) {
+            self[size] = 0;
+            stack[size++] = poly_constant(instr->arg.val);
+            continue;
+        }
+        if (instr->opcode == RPN_VAR) {
+            const int slot = instr->arg.slot;
+            self[size] = 0;
+            if (loop->current & SLOT_BIT(slot)) {
+                stack[size] = loop->value[slot];
+            } else if (slot == self_slot) {
+                self[size] = 1;
+                stack[size] = poly_constant(0);
+            } else if (!(loop->written & SLOT_BIT(slot)) && (loop->entry->known & SLOT_BIT(slot))) {
+                stack[size] = poly_constant(loop->entry->value[slot]);
+            } else {
+                return false;
+            }
+            size++;
+            continue;
+        }
+        // Both operands of & and | are evaluated here: a value is computed only if none of them stops
+        if (instr->opcode == RPN_AND_JUMP || instr->opcode == RPN_OR_JUMP)
+            continue;
+        if (instr->opcode != RPN_OP)
+            return false;
+        if (instr->arg.op == NOT) {
+            if (poly_degree(&stack[size - 1]) > 0 || self[size - 1] != 0)
+                return false;
+            stack[size - 1] = poly_constant(!stack[size - 1].coef[0]);
+            continue;
+        }
+        t_poly *a = &stack[size - 2];
+        const t_poly *b = &stack[--size];
+        uint32_t *self_a = &self[size - 1];
+        const uint32_t self_b = self[size];
+        const bool constant_a = poly_degree(a) <= 0 && *self_a == 0;
+        const bool constant_b = poly_degree(b) <= 0 && self_b == 0;
+        switch (instr->arg.op) {
+            case ADD:
+            case SUB:
+                for (int j = 0; j <= CLOSED_FORM_DEGREE; j++)
+                    a->coef[j] = instr->arg.op == ADD ? a->coef[j] + b->coef[j] : a->coef[j] - b->coef[j];
+                *self_a = instr->arg.op == ADD ? *self_a + self_b : *self_a - self_b;
+                break;
+            case MULT:
+                // The coefficient of the symbolic value stays a constant
+                if ((*self_a != 0 && !constant_b) || (self_b != 0 && !constant_a))
+                    return false;
+                *self_a = *self_a * b->coef[0] + self_b * a->coef[0];
+                if (!poly_mult(a, b, a))
+                    return false;
+                break;
+            case EXP: {
+                // Same results as fast_exp(): a negative exponent gives a
+                if (!constant_b || *self_a != 0)
+                    return false;
+                const int e = (int) b->coef[0];
+                if (constant_a) {
+                    *a = poly_constant(fast_exp((int) a->coef[0], e));
+                    break;
+                }
+                if (e > CLOSED_FORM_DEGREE)
+                    return false;
+                const t_poly base = *a;
+                if (e >= 0)
+                    *a = poly_constant(1);
+                for (int j = 0; j < e; j++) {
+                    if (!poly_mult(a, &base, a))
+                        return false;
+                }
+                break;
+            }
+            default: {
+                // Any other operator on constants, except the ones that stop the program
+                const int x = (int) a->coef[0];
+                const int y = (int) b->coef[0];
+                if (!constant_a || !constant_b || (instr->arg.op == DIV && (y == 0 || (x == INT_MIN && y == -1))))
+                    return false;
+                *a = poly_constant(apply_op(instr->arg.op, x, y));
+                break;
+            }
+        }
+    }
+    *depth = size;
+    return true;
+}
+
+// Value of the expression assigned to self_slot, self the coefficient of the value of self_slot in it
+bool poly_expr(const t_expr_rpn *expr, const t_counted_loop *loop, const int self_slot, t_poly *res,
+               uint32_t *self) {
+    t_poly *stack = malloc(expr->size * sizeof(t_poly));
+    uint32_t *selfs = malloc(expr->size * sizeof(uint32_t));
+    int depth;
+    const bool ok = poly_eval(expr, expr->size, loop, self_slot, stack, selfs, &depth) && depth == 1;
+    if (ok) {
+        *res = stack[0];
+        *self = selfs[0];
+    }
+    free(stack);
+    free(selfs);
+    return ok;
+}
+
+// Sum of the values of p at the iterations before k: C(k, j) becomes C(k, j + 1)
+bool poly_sum(const t_poly *p, t_poly *res) {
+    if (p->coef[CLOSED_FORM_DEGREE] != 0)
+        return false;
+    res->coef[0] = 0;
+    for (int j = 0; j < CLOSED_FORM_DEGREE; j++)
+        res->coef[j + 1] = p->coef[j];
+    return true;
+}
+
+// Number of iterations of a loop whose condition is x op n, with x = a + b * k (mod 2^32) at iteration k
+// Returns false if the loop never exits, or if it exits after wrapping around the condition
+bool trip_count(const uint32_t a, const uint32_t b, const operator_type op, const int n, uint64_t *count) {
+    if (op == EQUAL) {
+        *count = a != (uint32_t) n ? 0 : 1;
+        return a != (uint32_t) n || b != 0;
+    }
+    if (op == DIFF) {
+        // First k with b * k = n - a (mod 2^32): 2^s divides b, b / 2^s is invertible modulo 2^(32 - s)
+        const uint32_t target = (uint32_t) n - a;
+        if (target == 0) {
+            *count = 0;
+            return true;
+        }
+        if (b == 0)
+            return false;
+        int s = 0;
+        while (!(b & (1u << s)))
+            s++;
+        if (target & ((1u << s) - 1))
+            return false;
+        const uint32_t odd = b >> s;
+        uint32_t inverse = odd;
+        for (int i = 0; i < 5; i++)
+            inverse *= 2 - odd * inverse;
+        const uint32_t mask = s == 0 ? UINT32_MAX : (1u << (32 - s)) - 1;
+        *count = ((target >> s) * inverse) & mask;
+        return true;
+    }
+
+    // The condition holds on the interval of lo and width values: x - lo (mod 2^32) < width
+    int64_t lo, width;
+    switch (op) {
+        case LESS:      lo = INT_MIN; width = (int64_t) n - INT_MIN; break;
+        case LEQ:       lo = INT_MIN; width = (int64_t) n - INT_MIN + 1; break;
+        case GREATER:   lo = (int64_t) n + 1; width = (int64_t) INT_MAX - n; break;
+        case GEQ:       lo = n; width = (int64_t) INT_MAX - n + 1; break;
+        default:        return false;
+    }
+    const int64_t x = (uint32_t) (a - (uint32_t) lo);
+    if (x >= width) {
+        *count = 0;
+        return true;
+    }
+    const int64_t step = (int32_t) b;
+    if (step > 0) {
+        // x grows until it leaves the interval, which it must do before wrapping
+        const int64_t k = (width - x + step - 1) / step;
+        *count = k;
+        return x + step * k < ((int64_t) 1 << 32);
+    }
+    if (step < 0) {
+        // x decreases until it wraps, which must leave the interval
+        const int64_t k = x / -step + 1;
+        *count = k;
+        return x + step * k + ((int64_t) 1 << 32) >= width;
+    }
+    return false;
+}
+
+// Evaluates the loop in closed form: the assignments are executed in order while cond holds, from the values
+// known on entry; final receives the values of the slots assigned when the loop exits
+// Every variable assigned is known on entry, assigned once, and either accumulates (v = v + step: its value at
+// iteration k is a sum) or is read after its assignment only. Returns false if a value is not a polynomial of
+// k, or if the number of iterations cannot be proven
+bool closed_form(const t_counted_assignment *assignments, const int nb, const t_expr_rpn *cond,
+                 const t_values *entry, int final[NB_SLOTS]) {
+    t_counted_loop loop = { .entry = entry, .written = 0 };
+    if (nb == 0 || !is_well_formed_rpn(cond))
+        return false;
+    for (int i = 0; i < nb; i++) {
+        const uint64_t bit = SLOT_BIT(assignments[i].slot);
+        if ((loop.written & bit) || !(entry->known & bit) || !is_well_formed_rpn(assignments[i].expr))
+            return false;
+        loop.written |= bit;
+    }
+
+    // start: value of the accumulators at the start of iteration k, known once their step is
+    // assigned: value assigned to the other variables at iteration k
+    // The steps can read accumulators assigned later in the block: each round starts the accumulators whose
+    // step only reads known values
+    t_poly start[NB_SLOTS] = { { { 0 } } }, assigned[NB_SLOTS] = { { { 0 } } };
+    uint64_t started = 0;
+    bool complete = false;
+    for (int round = 0; round <= nb && !complete; round++) {
+        bool progress = false;
+        complete = true;
+        loop.current = started;
+        memcpy(loop.value, start, sizeof(start));
+        for (int i = 0; i < nb; i++) {
+            const int slot = assignments[i].slot;
+            t_poly value;
+            uint32_t self;
+            if (!poly_expr(assignments[i].expr, &loop, slot, &value, &self)) {
+                complete = false;
+                loop.current &= ~SLOT_BIT(slot);
+                continue;
+            }
+            if (self == 1) {
+                // The value is start + step(k): start is the entry value plus the sum of the previous steps
+                t_poly sum;
+                if (!poly_sum(&value, &sum))
+                    return false;
+                start[slot] = poly_constant(entry->value[slot]);
+                for (int j = 0; j <= CLOSED_FORM_DEGREE; j++) {
+                    start[slot].coef[j] += sum.coef[j];
+                    value.coef[j] += start[slot].coef[j];
+                }
+                started |= SLOT_BIT(slot);
+                progress = true;
+            } else if (self != 0) {
+                return false;
+            } else if (!(started & SLOT_BIT(slot))) {
+                assigned[slot] = value;
+            }
+            loop.value[slot] = value;
+            loop.current |= SLOT_BIT(slot);
+        }
+        if (!complete && !progress)
+            return false;
+    }
+    if (!complete)
+        return false;
+
+    // The condition is evaluated at the start of each iteration: x op n, x of degree 1 at most
+    loop.current = started;
+    memcpy(loop.value, start, sizeof(start));
+    const t_rpn_instr *last = &cond->code[cond->size - 1];
+    operator_type op = DIFF;
+    t_poly *stack = malloc(cond->size * sizeof(t_poly));
+    uint32_t *self = malloc(cond->size * sizeof(uint32_t));
+    t_poly x = poly_constant(0), n = poly_constant(0);
+    int depth;
+    bool counted;
+    if (last->opcode == RPN_OP && last->arg.op >= EQUAL && last->arg.op <= GEQ) {
+        static const operator_type swapped[] = {
+            [EQUAL] = EQUAL, [DIFF] = DIFF, [LESS] = GREATER, [GREATER] = LESS, [LEQ] = GEQ, [GEQ] = LEQ
+        };
+        op = last->arg.op;
+        counted = poly_eval(cond, cond->size - 1, &loop, -1, stack, self, &depth) && depth == 2;
+        if (counted && poly_degree(&stack[1]) <= 0) {
+            x = stack[0];
+            n = stack[1];
+        } else if (counted && poly_degree(&stack[0]) <= 0) {
+            x = stack[1];
+            n = stack[0];
+            op = swapped[op];
+        } else {
+            counted = false;
+        }
+    } else {
+        counted = poly_eval(cond, cond->size, &loop, -1, stack, self, &depth) && depth == 1;
+        if (counted)
+            x = stack[0];
+    }
+    free(stack);
+    free(self);
+    uint64_t count;
+    if (!counted || poly_degree(&x) > 1 || !trip_count(x.coef[0], x.coef[1], op, (int) n.coef[0], &count))
+        return false;
+
+    for (int i = 0; i < nb; i++) {
+        const int slot = assignments[i].slot;
+        if (started & SLOT_BIT(slot))
+            final[slot] = poly_at(&start[slot], count);
+        else
+            final[slot] = count > 0 ? poly_at(&assigned[slot], count - 1) : entry->value[slot];
+    }
+    return true;
+}
+
+// The expression becomes the constant value
+void set_constant_rpn(t_expr_rpn *expr, const int value) {
+    expr->code[0].opcode = RPN_CONST;
+    expr->code[0].arg.val = value;
+    expr->size = 1;
+    update_max_depth_rpn(expr);
+}
+
+// Replaces the loop *link, a While or For loop whose block only contains assignments, by the assignments of
+// the values of its variables when it exits, if the loop has a closed form with the known values
+// The assignments of the block are kept with a constant expression, a For node becomes the assignment of its
+// variable. Returns true if the loop is replaced: *link is the first assignment
+bool close_loop(t_ast **link, const t_values *values, t_opt_stats *stats) {
+    t_ast *node = *link;
+    const bool is_for = node->command == For;
+    t_ast *block = is_for ? node->statement.for_st.block : node->statement.while_st.block;
+    t_counted_assignment assignments[NB_SLOTS + 1];
+    int nb = 0;
+    t_ast *last = NULL;
+    for (t_ast *st = block; st != NULL; st = st->next) {
+        if (st->command != Assignment || nb == NB_SLOTS)
+            return false;
+        t_assignment_statement *assignment = &st->statement.assignment_st;
+        assignments[nb++] = (t_counted_assignment) { .slot = var_slot(assignment->var), .expr = &assignment->expr };
+        last = st;
+    }
+    if (is_for)
+        assignments[nb++] = (t_counted_assignment) {
+            .slot = for_var_slot(&node->statement.for_st), .expr = &node->statement.for_st.expr
+        };
+
+    int final[NB_SLOTS];
+    const t_expr_rpn *cond = is_for ? &node->statement.for_st.cond : &node->statement.while_st.cond;
+    if (!closed_form(assignments, nb, cond, values, final))
+        return false;
+
+    for (int i = 0; i < nb; i++)
+        set_constant_rpn(assignments[i].expr, final[assignments[i].slot]);
+    stats->closed_loops++;
+    if (is_for) {
+        const t_assignment_statement update = {
+            .var = 'a' + for_var_slot(&node->statement.for_st), .expr = node->statement.for_st.expr
+        };
+        node->command = Assignment;
+        node->statement.assignment_st = update;
+        if (block != NULL) {
+            last->next = node;
+            *link = block;
+        }
+    } else {
+        last->next = node->next;
+        *link = block;
+    }
+    return true;
+}
+
+// Propagates the known values through the list starting at *link; statements are replaced or removed by
+// changing the links of the list
+// Returns true if the list never reaches its end: it stops at a return statement, or in a loop that never exits
+bool propagate_list(t_ast **link, t_values *values, t_opt_stats *stats) {
+    while (*link != NULL) {
+        t_ast *node = *link;
+        bool stops = false;
+        switch (node->command) {
+            case Assignment: {
+                t_assignment_statement *st = &node->statement.assignment_st;
+                propagate_expr(&st->expr, values, stats);
+                assign_value(values, var_slot(st->var), &st->expr);
+                break;
+            }
+            case Print:
+                if (node->statement.print_st.expr_type == RPN)
+                    propagate_expr(&node->statement.print_st.expr, values, stats);
+                break;
+            case Return:
+                propagate_expr(&node->statement.return_st.expr, values, stats);
+                stops = true;
+                break;
+            case If: {
+                t_if_statement *st = &node->statement.if_st;
+                propagate_expr(&st->cond, values, stats);
+                int cond;
+                if (is_constant_rpn(&st->cond, &cond)) {
+                    // The branch taken replaces the If statement, its statements are propagated in the list
+                    t_ast *branch = cond ? st->if_true : st->if_false;
+                    stats->folded_ifs++;
+                    stats->removed_statements += count_statements(cond ? st->if_false : st->if_true);
+                    if (branch == NULL) {
+                        *link = node->next;
+                    } else {
+                        t_ast *last = branch;
+                        while (last->next != NULL)
+                            last = last->next;
+                        last->next = node->next;
+                        *link = branch;
+                    }
+                    continue;
+                }
+                t_values false_values = *values;
+                const bool true_stops = propagate_list(&st->if_true, values, stats);
+                const bool false_stops = propagate_list(&st->if_false, &false_values, stats);
+                if (true_stops)
+                    *values = false_values;
+                else if (!false_stops)
+                    join_values(values, &false_values);
+                stops = true_stops && false_stops;
+                break;
+            }
+            case While: {
+                t_while_statement *st = &node->statement.while_st;
+                int cond;
+                if (constant_value(&st->cond, values, &cond) && !cond) {
+                    stats->removed_loops++;
+                    stats->removed_statements += count_statements(st->block);
+                    *link = node->next;
+                    continue;
+                }
+                if (close_loop(link, values, stats))
+                    continue;
+                // At each evaluation of the condition, the variables assigned by the loop are unknown
+                values->known &= ~written_slots(st->block);
+                propagate_expr(&st->cond, values, stats);
+                t_values block_values = *values;
+                propagate_list(&st->block, &block_values, stats);
+                stops = is_constant_rpn(&st->cond, &cond) && cond;
+                break;
+            }
+            case For: {
+                t_for_statement *st = &node->statement.for_st;
+                const int slot = for_var_slot(st);
+                if (st->init_type == ASSIGNMENT) {
+                    propagate_expr(&st->init.assignment.expr, values, stats);
+                    assign_value(values, slot, &st->init.assignment.expr);
+                }
+                int cond;
+                if (constant_value(&st->cond, values, &cond) && !cond) {
+                    // Only the initialization is executed
+                    stats->removed_loops++;
+                    stats->removed_statements += count_statements(st->block);
+                    if (st->init_type == VAR) {
+                        *link = node->next;
+                        continue;
+                    }
+                    const t_assignment_statement init = st->init.assignment;
+                    node->command = Assignment;
+                    node->statement.assignment_st = init;
+                    break;
+                }
+                if (close_loop(link, values, stats))
+                    continue;
+                values->known &= ~(SLOT_BIT(slot) | written_slots(st->block));
+                propagate_expr(&st->cond, values, stats);
+                propagate_expr(&st->expr, values, stats);
+                t_values block_values = *values;
+                propagate_list(&st->block, &block_values, stats);
+                stops = is_constant_rpn(&st->cond, &cond) && cond;
+                break;
+            }
+        }
+        // The statements after it are never reached
+        if (stops) {
+            stats->removed_statements += count_statements(node->next);
+            node->next = NULL;
+            return true;
+        }
+        link = &node->next;
+    }
+    return false;
+}
+
+void propagate_constants(t_ast **prog, const uint64_t inputs, t_opt_stats *stats) {
+    // The variables start at 0, except the inputs
+    t_values values = { .known = 0 };
+    for (int slot = 0; slot < NB_VARIABLES; slot++) {
+        if (!(inputs & SLOT_BIT(slot)))
+            values.known |= SLOT_BIT(slot);
+        values.value[slot] = 0;
+    }
+    propagate_list(prog, &values, stats);
+}
+
+////////////////////////////////////////////////////////////////////
+// Loop-invariant code motion
+
+// Loop whose invariant subexpressions are being hoisted
+typedef struct {
+    uint64_t written;                   // slots assigned by the loop
+    int first_temp;                     // first temporary the loop can take, the ones below belong to enclosing loops
+    int nb_temps;                       // temporaries taken by the loop
+    t_ast *hoisted[NB_TEMPORARIES];     // assignment of each temporary taken, inserted before the loop
+} t_loop;
+
+// Subexpression of an RPN expression, ending at one of its instructions
+typedef struct {
+    int start;          // index of its first instruction
+    bool invariant;     // reads no variable assigned by the loop
+    bool safe;          // cannot stop the program
+    bool reads_var;
+} t_subexpr;
+
+// Returns the temporary holding the subexpression code[0..size-1], a new one if no other subexpression of
+// the loop is identical; -1 if every temporary is taken
+int loop_temporary(t_loop *loop, const t_rpn_instr *code, const int size, t_arena *arena, t_opt_stats *stats) {
+    for (int k = 0; k < loop->nb_temps; k++) {
+        const t_expr_rpn *hoisted = &loop->hoisted[k]->statement.assignment_st.expr;
+        if (same_rpn_code(hoisted->code, hoisted->size, code, size)) {
+            stats->reused++;
+            return loop->first_temp + k;
+        }
+    }
+    if (loop->first_temp + loop->nb_temps >= NB_TEMPORARIES)
+        return -1;
+
+    const int temp = loop->first_temp + loop->nb_temps;
+    t_ast *node = arena_alloc(arena, sizeof(t_ast));
+    node->command = Assignment;
+    node->next = NULL;
+    t_assignment_statement *st = &node->statement.assignment_st;
+    st->var = (char) ('a' + NB_VARIABLES + temp);
+    st->expr.code = arena_alloc(arena, size * sizeof(t_rpn_instr));
+    memcpy(st->expr.code, code, size * sizeof(t_rpn_instr));
+    st->expr.size = size;
+    update_max_depth_rpn(&st->expr);
+    loop->hoisted[loop->nb_temps++] = node;
+    stats->hoisted++;
+    return temp;
+}
+
+// Replaces the largest invariant subexpressions of expr by the temporaries of the loop
+// Only subexpressions with an operator and a variable are worth a temporary; malformed expressions are left
+// as they are, their error is reported when they are evaluated
+void hoist_expr(t_expr_rpn *expr, t_loop *loop, t_arena *arena, t_opt_stats *stats) {
+    const int n = expr->size;
+    if (n < 2)
+        return;
+    const t_rpn_instr *code = expr->code;
+    t_subexpr *sub = malloc(n * sizeof(t_subexpr));
+    int *stack = malloc(n * sizeof(int));
+    int size = 0;
+    bool well_formed = true;
+    for (int i = 0; i < n && well_formed; i++) {
+        const t_rpn_instr *instr = &code[i];
+        if (instr->opcode == RPN_AND_JUMP || instr->opcode == RPN_OR_JUMP)
+            continue;
+        if (instr->opcode != RPN_OP) {
+            const bool is_var = instr->opcode == RPN_VAR;
+            sub[i] = (t_subexpr) { .start = i, .invariant = !is_var || !(loop->written & SLOT_BIT(instr->arg.slot)),
+                                   .safe = true, .reads_var = is_var };
+            stack[size++] = i;
+        } else if (instr->arg.op == NOT) {
+            well_formed = size >= 1;
+            if (well_formed) {
+                sub[i] = sub[stack[size - 1]];
+                stack[size - 1] = i;
+            }
+        } else {
+            well_formed = size >= 2;
+            if (!well_formed)
+                break;
+            const t_subexpr *b = &sub[stack[--size]];
+            const t_subexpr *a = &sub[stack[size - 1]];
+            // A division stops the program on a zero divisor, and INT_MIN / -1 traps
+            const bool safe_op = instr->arg.op != DIV
+                || (b->start == i - 1 && code[i - 1].opcode == RPN_CONST && code[i - 1].arg.val != 0
+                    && code[i - 1].arg.val != -1);
+            sub[i] = (t_subexpr) { .start = a->start, .invariant = a->invariant && b->invariant,
+                                   .safe = a->safe && b->safe && safe_op, .reads_var = a->reads_var || b->reads_var };
+            stack[size - 1] = i;
+        }
+    }
+
+    // largest[i]: end of the largest subexpression to hoist starting at instruction i, -1 if none
+    // (the stack is reused for it)
+    int *largest = stack;
+    bool found = false;
+    if (well_formed && size == 1) {
+        for (int i = 0; i < n; i++) {
+            largest[i] = -1;
+        }
+        for (int i = 0; i < n; i++) {
+            if (code[i].opcode == RPN_OP && sub[i].invariant && sub[i].safe && sub[i].reads_var) {
+                largest[sub[i].start] = i;
+                found = true;
+            }
+        }
+    }
+
+    if (found) {
+        t_rpn_instr *new_code = arena_alloc(arena, n * sizeof(t_rpn_instr));
+        int new_size = 0;
+        for (int i = 0; i < n;) {
+            const int end = largest[i];
+            const int temp = end >= 0 ? loop_temporary(loop, code + i, end - i + 1, arena, stats) : -1;
+            if (temp >= 0) {
+                new_code[new_size].opcode = RPN_VAR;
+                new_code[new_size].arg.slot = NB_VARIABLES + temp;
+                new_size++;
+                i = end + 1;
+            } else {
+                new_code[new_size++] = code[i++];
+            }
+        }
+        if (new_size < n) {
+            expr->code = new_code;
+            expr->size = new_size;
+            update_max_depth_rpn(expr);
+        }
+    }
+    free(sub);
+    free(stack);
+}
+
+// Hoists the invariant subexpressions of the statements of the list and their nested blocks: every expression
+// of the list is evaluated at each iteration of the loop
+void hoist_statements(t_ast *prog, t_loop *loop, t_arena *arena, t_opt_stats *stats) {
+    for (; prog != NULL; prog = prog->next) {
+        switch (prog->command) {
+            case Assignment:
+                hoist_expr(&prog->statement.assignment_st.expr, loop, arena, stats);
+                break;
+            case Print:
+                if (prog->statement.print_st.expr_type == RPN)
+                    hoist_expr(&prog->statement.print_st.expr, loop, arena, stats);
+                break;
+            case Return:
+                hoist_expr(&prog->statement.return_st.expr, loop, arena, stats);
+                break;
+            case If:
+                hoist_expr(&prog->statement.if_st.cond, loop, arena, stats);
+                hoist_statements(prog->statement.if_st.if_true, loop, arena, stats);
+                hoist_statements(prog->statement.if_st.if_false, loop, arena, stats);
+                break;
+            case While:
+                hoist_expr(&prog->statement.while_st.cond, loop, arena, stats);
+                hoist_statements(prog->statement.while_st.block, loop, arena, stats);
+                break;
+            case For: {
+                t_for_statement *st = &prog->statement.for_st;
+                if (st->init_type == ASSIGNMENT)
+                    hoist_expr(&st->init.assignment.expr, loop, arena, stats);
+                hoist_expr(&st->cond, loop, arena, stats);
+                hoist_expr(&st->expr, loop, arena, stats);
+                hoist_statements(st->block, loop, arena, stats);
+                break;
+            }
+        }
+    }
+}
+
+// Hoists the invariant subexpressions of the loop node, with the temporaries from first_temp on
+// Their assignments are inserted before the loop: node becomes the first assignment, the loop is moved after
+// the last one
+// Returns the node of the loop, sets nb_temps to the number of temporaries taken
+t_ast *hoist_loop(t_ast *node, const int first_temp, int *nb_temps, t_arena *arena, t_opt_stats *stats) {
+    t_loop loop = { .first_temp = first_temp, .nb_temps = 0 };
+    stats->loops++;
+    if (node->command == While) {
+        t_while_statement *st = &node->statement.while_st;
+        loop.written = written_slots(st->block);
+        hoist_expr(&st->cond, &loop, arena, stats);
+        hoist_statements(st->block, &loop, arena, stats);
+    } else {
+        // The initialization is evaluated once, before the loop
+        t_for_statement *st = &node->statement.for_st;
+        loop.written = SLOT_BIT(for_var_slot(st)) | written_slots(st->block);
+        hoist_expr(&st->cond, &loop, arena, stats);
+        hoist_expr(&st->expr, &loop, arena, stats);
+        hoist_statements(st->block, &loop, arena, stats);
+    }
+
+    *nb_temps = loop.nb_temps;
+    if (loop.nb_temps == 0)
+        return node;
+    t_ast *moved = arena_alloc(arena, sizeof(t_ast));
+    *moved = *node;
+    for (int k = 0; k + 1 < loop.nb_temps; k++) {
+        loop.hoisted[k]->next = loop.hoisted[k + 1];
+    }
+    loop.hoisted[loop.nb_temps - 1]->next = moved;
+    *node = *loop.hoisted[0];
+    return moved;
+}
+
+// Hoists the invariants of the loops of the list, then of the loops nested in their blocks
+// The temporaries below first_temp hold invariants of the enclosing loops; sibling loops reuse the same ones
+void hoist_list(t_ast *prog, const int first_temp, t_arena *arena, t_opt_stats *stats) {
+    for (; prog != NULL; prog = prog->next) {
+        switch (prog->command) {
+            case If:
+                hoist_list(prog->statement.if_st.if_true, first_temp, arena, stats);
+                hoist_list(prog->statement.if_st.if_false, first_temp, arena, stats);
+                break;
+            case While:
+            case For: {
+                int nb_temps;
+                prog = hoist_loop(prog, first_temp, &nb_temps, arena, stats);
+                t_ast *block = prog->command == While ? prog->statement.while_st.block : prog->statement.for_st.block;
+                hoist_list(block, first_temp + nb_temps, arena, stats);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void hoist_loop_invariants(t_ast *prog, t_arena *arena, t_opt_stats *stats) {
+    hoist_list(prog, 0, arena, stats);
+}
+
+////////////////////////////////////////////////////////////////////
+// Strength reduction
+
+// Returns k if value is 2^k with k in [0, 30], -1 otherwise
+int power_of_two(const int value) {
+    if (value <= 0 || (value & (value - 1)) != 0)
+        return -1;
+    int k = 0;
+    while ((1 << k) != value)
+        k++;
+    return k;
+}
+
+// Rewrites the expression in place: code[0 .. size) is the result, starts[] the index in the result where
+// each value of the stack begins. A malformed expression is left as it is
+void reduce_expr(t_expr_rpn *expr, t_opt_stats *stats) {
+    if (!is_well_formed_rpn(expr))
+        return;
+    t_rpn_instr *code = expr->code;
+    int *starts = malloc(expr->size * sizeof(int));
+    int depth = 0;
+    int size = 0;
+    bool changed = false;
+
+    for (int i = 0; i < expr->size; i++) {
+        const t_rpn_instr instr = code[i];
+        if (instr.opcode != RPN_OP || instr.arg.op == NOT) {
+            if (instr.opcode == RPN_CONST || instr.opcode == RPN_VAR)
+                starts[depth++] = size;
+            code[size++] = instr;
+            continue;
+        }
+        const int b = starts[--depth];
+        const int a = starts[depth - 1];
+        const bool const_b = size - b == 1 && code[b].opcode == RPN_CONST;
+        const bool const_a = b - a == 1 && code[a].opcode == RPN_CONST;
+        const int val_b = code[b].arg.val;
+
+        if (instr.arg.op == MULT && const_b && power_of_two(val_b) >= 0) {
+            // x * 2^k: the constant becomes the shift, x * 1 is x
+            const int k = power_of_two(val_b);
+            if (k == 0) {
+                size--;
+            } else {
+                code[b].opcode = RPN_SHL;
+                code[b].arg.shift = k;
+            }
+        } else if (instr.arg.op == MULT && const_a && power_of_two(code[a].arg.val) >= 0) {
+            // 2^k * x: x moves over the constant
+            const int k = power_of_two(code[a].arg.val);
+            memmove(&code[a], &code[b], (size - b) * sizeof(t_rpn_instr));
+            size--;
+            if (k > 0) {
+                code[size].opcode = RPN_SHL;
+                code[size++].arg.shift = k;
+            }
+        } else if (instr.arg.op == DIV && const_b && val_b != 0 && val_b != -1 && val_b != INT_MIN) {
+            if (val_b == 1) {
+                size--;
+            } else {
+                code[b].opcode = RPN_DIV_CONST;
+                code[b].arg.div = div_const_of(val_b);
+            }
+        } else if (instr.arg.op == EXP && const_b && (val_b == 2 || val_b == 3)) {
+            code[b].opcode = val_b == 2 ? RPN_SQUARE : RPN_CUBE;
+        } else {
+            code[size++] = instr;
+            continue;
+        }
+        stats->reduced++;
+        changed = true;
+    }
+    free(starts);
+    if (changed) {
+        expr->size = size;
+        update_max_depth_rpn(expr);
+    }
+}
+
+void reduce_strength(t_ast *prog, t_opt_stats *stats) {
+    for (; prog != NULL; prog = prog->next) {
+        switch (prog->command) {
+            case Assignment:
+                reduce_expr(&prog->statement.assignment_st.expr, stats);
+                break;
+            case Print:
+                if (prog->statement.print_st.expr_type == RPN)
+                    reduce_expr(&prog->statement.print_st.expr, stats);
+                break;
+            case Return:
+                reduce_expr(&prog->statement.return_st.expr, stats);
+                break;
+            case If:
+                reduce_expr(&prog->statement.if_st.cond, stats);
+                reduce_strength(prog->statement.if_st.if_true, stats);
+                reduce_strength(prog->statement.if_st.if_false, stats);
+                break;
+            case While:
+                reduce_expr(&prog->statement.while_st.cond, stats);
+                reduce_strength(prog->statement.while_st.block, stats);
+                break;
+            case For: {
+                t_for_statement *st = &prog->statement.for_st;
+                if (st->init_type == ASSIGNMENT)
+                    reduce_expr(&st->init.assignment.expr, stats);
+                reduce_expr(&st->cond, stats);
+                reduce_expr(&st->expr, stats);
+                reduce_strength(st->block, stats);
+                break;
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void optimize_program(t_ast **prog, t_arena *arena, const uint64_t inputs, t_opt_stats *stats) {
+    memset(stats, 0, sizeof(t_opt_stats));
+    propagate_constants(prog, inputs, stats);
+    hoist_loop_invariants(*prog, arena, stats);
+    reduce_strength(*prog, stats);
+}
+
+void print_opt_stats(FILE *file, const t_opt_stats *stats) {
+    fprintf(file, "constant propagation: %d variable reads replaced by their value, %d if folded, %d loops removed, "
+            "%d loops in closed form, %d statements removed\n", stats->propagated, stats->folded_ifs,
+            stats->removed_loops, stats->closed_loops, stats->removed_statements);
+    fprintf(file, "loop invariants: %d loops, %d subexpressions hoisted, %d reused\n",
+            stats->loops, stats->hoisted, stats->reused);
+    fprintf(file, "strength reduction: %d operators specialized\n", stats->reduced);
+}
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "program/parallel_lexer.h"
+#include "program/lexer.h"
+#include "program/error.h"
+#include "structures/task_pool.h"
+
+// Below this size per chunk, splitting costs more than it saves
+#ifndef PARALLEL_LEX_MIN_CHUNK
+#define PARALLEL_LEX_MIN_CHUNK (64 * 1024)
+#endif
+// More chunks than threads, so that the pool can balance the work
+#define CHUNKS_PER_THREAD 4
+
+// Line of a chunk where the lexer of the chunk could be joined
+typedef struct {
+    const char *s;          // first character of the line
+    t_lexer_state state;    // state of the lexer of the chunk before this character
+    int nb_tokens;          // tokens of the chunk before this line
+    long diag_size;         // size of the diagnostics of the chunk before this line
+} t_lex_checkpoint;
+
+typedef struct {
+    const char *begin;
+    const char *end;
+    t_arena arena;                  // the expressions of the tokens of the chunk
+    t_prog_token_list tokens;
+    t_lex_checkpoint *checkpoints;
+    int nb_checkpoints;
+    int capacity;
+    FILE *diag_stream;              // diagnostics written while the chunk is lexed
+    char *diag;
+    size_t diag_size;
+    bool error;                     // the lexing of the chunk stopped on an error
+    const char *stop;               // where the lexing of the chunk stopped, if there was no error
+    t_lexer_state state;            // state of the lexer at stop
+} t_lex_chunk;
+
+// Joining the chunk: the lexer searches a checkpoint where it has the same state
+typedef struct {
+    const t_lex_chunk *chunk;
+    int next;   // first checkpoint not passed yet
+    int found;  // checkpoint reached, -1 if none yet
+} t_lex_sync;
+
+bool record_checkpoint(void *ctx, const char *s, const t_lexer_state *state, const int nb_tokens) {
+    t_lex_chunk *chunk = ctx;
+    if (chunk->nb_checkpoints >= chunk->capacity) {
+        chunk->capacity = chunk->capacity == 0 ? 64 : 2 * chunk->capacity;
+        chunk->checkpoints = realloc(chunk->checkpoints, chunk->capacity * sizeof(t_lex_checkpoint));
+    }
+    t_lex_checkpoint *checkpoint = &chunk->checkpoints[chunk->nb_checkpoints++];
+    checkpoint->s = s;
+    checkpoint->state = *state;
+    checkpoint->nb_tokens = nb_tokens;
+    checkpoint->diag_size = ftell(chunk->diag_stream);
+    return false;
+}
+
+bool find_checkpoint(void *ctx, const char *s, const t_lexer_state *state, const int nb_tokens) {
+    (void) nb_tokens;
+    t_lex_sync *sync = ctx;
+    const t_lex_chunk *chunk = sync->chunk;
+    while (sync->next < chunk->nb_checkpoints && chunk->checkpoints[sync->next].s < s)
+        sync->next++;
+    if (sync->next < chunk->nb_checkpoints && chunk->checkpoints[sync->next].s == s
+        && lexer_state_equal(&chunk->checkpoints[sync->next].state, state)) {
+        sync->found = sync->next;
+        return true;
+    }
+    return false;
+}
+
+// Task of the pool: lexes one chunk from the initial state, its diagnostics are kept for the join
+void lex_chunk(void *arg, const int index) {
+    t_lex_chunk *chunk = &((t_lex_chunk *) arg)[index];
+    chunk->arena = create_arena();
+    chunk->tokens = ptl_create_empty_list();
+    chunk->diag_stream = open_memstream(&chunk->diag, &chunk->diag_size);
+    chunk->state = lexer_initial_state();
+
+    FILE *const caller_output = error_output;
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    error_output = chunk->diag_stream;
+    error_recovery = &recovery;
+    if (setjmp(recovery) == 0) {
+        chunk->stop = lex_range(chunk->begin, chunk->end, &chunk->state, &chunk->arena, &chunk->tokens,
+                                record_checkpoint, chunk);
+    } else {
+        chunk->error = true;
+    }
+    error_recovery = caller_recovery;
+    error_output = caller_output;
+    fclose(chunk->diag_stream);
+}
+
+// Returns the first line starting in column 0 at or after p, end if there is none
+const char *next_top_level_line(const char *p, const char *begin, const char *end) {
+    while (p < end && (p == begin || p[-1] != '\n' || *p == ' ' || *p == '\n' || *p == '\r'))
+        p++;
+    return p;
+}
+
+void destroy_lex_chunks(t_lex_chunk *chunks, const int nb_chunks) {
+    for (int i = 0; i < nb_chunks; i++) {
+        destroy_arena(&chunks[i].arena);
+        ptl_destroy_list(&chunks[i].tokens);
+        free(chunks[i].checkpoints);
+        free(chunks[i].diag);
+    }
+    free(chunks);
+}
+
+t_prog_token_list lex_parallel(const char *s, const size_t len, t_arena *arena, const int nb_threads) {
+    int max_chunks = nb_threads * CHUNKS_PER_THREAD;
+    if (len / PARALLEL_LEX_MIN_CHUNK < (size_t) max_chunks)
+        max_chunks = (int) (len / PARALLEL_LEX_MIN_CHUNK);
+    if (nb_threads <= 1 || max_chunks < 2)
+        return lex(s, len, arena);
+
+    // Split points: lines starting in column 0, near multiples of len / max_chunks
+    t_lex_chunk *const chunks = calloc(max_chunks, sizeof(t_lex_chunk));
+    int nb_chunks = 0;
+    const char *start = s;
+    for (int k = 1; k <= max_chunks; k++) {
+        const char *stop = k == max_chunks ? s + len : next_top_level_line(s + len * k / max_chunks, s, s + len);
+        if (stop > start) {
+            chunks[nb_chunks].begin = start;
+            chunks[nb_chunks].end = stop;
+            nb_chunks++;
+            start = stop;
+        }
+    }
+
+    // Kept in the arena: it is still reachable if an error jumps out of the join
+    t_prog_token_list *const list = arena_alloc(arena, sizeof(t_prog_token_list));
+    *list = ptl_create_empty_list();
+
+    // If the error is recovered by the caller, everything is released before jumping back to it
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    if (caller_recovery != NULL) {
+        if (setjmp(recovery) != 0) {
+            error_recovery = caller_recovery;
+            destroy_lex_chunks(chunks, nb_chunks);
+            ptl_destroy_list(list);
+            longjmp(*caller_recovery, 1);
+        }
+        error_recovery = &recovery;
+    }
+
+    run_parallel_tasks(nb_chunks, nb_threads, lex_chunk, chunks);
+
+    // Join, in order: the lexer continues from its actual state until it meets the state of the chunk
+    // at one of its checkpoints, then the tokens and diagnostics of the chunk from there are kept
+    const char *p = s;
+    t_lexer_state state = lexer_initial_state();
+    for (int i = 0; i < nb_chunks; i++) {
+        const t_lex_chunk *chunk = &chunks[i];
+        t_lex_sync sync = { .chunk = chunk, .next = 0, .found = -1 };
+        p = lex_range(p, chunk->end, &state, arena, list, find_checkpoint, &sync);
+        if (sync.found < 0)
+            continue;
+
+        const t_lex_checkpoint *checkpoint = &chunk->checkpoints[sync.found];
+        for (int j = checkpoint->nb_tokens; j < chunk->tokens.size; j++) {
+            ptl_push_back(list, chunk->tokens.data[j]);
+        }
+        fwrite(chunk->diag + checkpoint->diag_size, 1, chunk->diag_size - checkpoint->diag_size, error_stream());
+        if (chunk->error)
+            program_error();
+        p = chunk->stop;
+        state = chunk->state;
+    }
+
+    error_recovery = caller_recovery;
+    for (int i = 0; i < nb_chunks; i++) {
+        arena_merge(arena, &chunks[i].arena);
+    }
+    destroy_lex_chunks(chunks, nb_chunks);
+    return *list;
+}
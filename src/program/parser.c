@@ -1,48 +1,90 @@
-
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "program/program.h"
 #include "program/lexical.h"
+#include "program/error.h"
 
 #include "program/parser.h"
 
+#define INIT_CAPACITY 16
 
-void get_expr_rpn(t_expr_rpn *expr, const t_prog_token_list *list, unsigned int *i) {
-    t_prog_token token = ptl_get(list, *i);
+void get_expr_rpn(t_expr_rpn *expr, t_parser *parser) {
+    if (parser->i >= parser->list->size) {
+        fprintf(error_stream(), "Expression expected\n");
+        parser->error = true;
+        return;
+    }
+    t_prog_token token = ptl_get(parser->list, parser->i);
     if (token.token_type != PT_EXPR) {
-        printf("Expression expected\n");
-        *i = (unsigned int) (-1);
+        fprintf(error_stream(), "Expression expected\n");
+        parser->error = true;
         return;
     }
     *expr = token.content.expr_rpn;
-    (*i)++;
+    parser->i++;
 }
 
 bool is_token_expr_or_string(const t_prog_token *token) {
     return token->token_type == PT_EXPR || token->token_type == PT_STRING;
 }
 
-static bool is_else = false;
+t_parser create_parser(const t_prog_token_list *token_list, t_arena *arena) {
+    t_parser parser;
+    parser.list = token_list;
+    parser.i = 0;
+    parser.arena = arena;
+    parser.is_else = false;
+    parser.error = false;
+    parser.frames = NULL;
+    parser.nb_frames = 0;
+    parser.capacity = 0;
+    parser.top_level = NULL;
+    return parser;
+}
+
+void push_parser_frame(t_parser *parser, const e_block_type type, t_ast *owner) {
+    if (parser->nb_frames >= parser->capacity) {
+        parser->capacity = parser->capacity == 0 ? INIT_CAPACITY : 2 * parser->capacity;
+        parser->frames = realloc(parser->frames, parser->capacity * sizeof(t_parser_frame));
+    }
+    t_parser_frame *frame = &parser->frames[parser->nb_frames++];
+    frame->type = type;
+    frame->owner = owner;
+    frame->head = NULL;
+    frame->tail = NULL;
+}
 
-t_ast *parse_aux(const t_prog_token_list *list, unsigned int *i) {
+// Appends the statement at the end of the list being parsed
+void append_statement(t_parser *parser, t_ast *prog) {
+    t_parser_frame *frame = &parser->frames[parser->nb_frames - 1];
+    prog->next = NULL;
+    if (frame->tail == NULL)
+        frame->head = prog;
+    else
+        frame->tail->next = prog;
+    frame->tail = prog;
+}
 
-    if (*i >= list->size)
-        return NULL;
+// Parses the statement starting at the current token
+// The blocks of if, while and for statements are not parsed here: they are parsed as new statement lists
+// Returns NULL and sets parser->error on syntax error
+t_ast *parse_statement(t_parser *parser) {
 
-    t_ast *prog = malloc(sizeof(t_ast)); // Current node of the AST
+    const t_prog_token_list *list = parser->list;
+    t_ast *prog = arena_alloc(parser->arena, sizeof(t_ast)); // Current node of the AST
+    prog->next = NULL;
     u_statement statement;
-    const t_prog_token token = ptl_get(list, *i);
+    const t_prog_token token = ptl_get(list, parser->i);
     switch (token.token_type) {
         case PT_VAR: {
             prog->command = Assignment;
             t_assignment_statement st;
             st.var = token.content.var;
-            *i = *i+2;
-            get_expr_rpn(&st.expr, list, i);
+            parser->i += 2;
+            get_expr_rpn(&st.expr, parser);
             statement.assignment_st = st;
             prog->statement = statement;
-            // prog->... = ...
             break;
         }
         case PT_KEYWORD: {
@@ -50,20 +92,25 @@ t_ast *parse_aux(const t_prog_token_list *list, unsigned int *i) {
                 case KW_PRINT: {
                     prog->command = Print;
                     t_print_statement st;
-                    (*i)++;
-                    const t_prog_token print_expr_token = ptl_get(list, *i);
+                    parser->i++;
+                    if (parser->i >= list->size) {
+                        fprintf(error_stream(), "Expression expected\n");
+                        parser->error = true;
+                        break;
+                    }
+                    const t_prog_token print_expr_token = ptl_get(list, parser->i);
                     if (!is_token_expr_or_string(&print_expr_token)) {
-                        printf("Expression expected\n");
-                        *i = (unsigned int) (-1);
+                        fprintf(error_stream(), "Expression expected\n");
+                        parser->error = true;
                         break;
                     }
                     if (print_expr_token.token_type == PT_EXPR) {
                         st.expr_type = RPN;
-                        get_expr_rpn(&st.expr, list, i);
+                        get_expr_rpn(&st.expr, parser);
                     } else {
                         st.expr_type = STR;
                         st.string = print_expr_token.content.expr;
-                        (*i)++;
+                        parser->i++;
                     }
                     statement.print_st = st;
                     prog->statement = statement;
@@ -72,8 +119,8 @@ t_ast *parse_aux(const t_prog_token_list *list, unsigned int *i) {
                 case KW_RETURN: {
                     prog->command = Return;
                     t_return_statement st;
-                    (*i)++;
-                    get_expr_rpn(&st.expr, list, i);
+                    parser->i++;
+                    get_expr_rpn(&st.expr, parser);
                     statement.return_st = st;
                     prog->statement = statement;
                     break;
@@ -81,15 +128,10 @@ t_ast *parse_aux(const t_prog_token_list *list, unsigned int *i) {
                 case KW_IF: {
                     prog->command = If;
                     t_if_statement st;
-                    (*i)++;
-                    get_expr_rpn(&st.cond, list, i);
-                    st.if_true  = parse_aux(list, i);
-                    if (is_else) {
-                        is_else = false;
-                        st.if_false = parse_aux(list, i);
-                    } else {
-                        st.if_false = NULL;
-                    }
+                    parser->i++;
+                    get_expr_rpn(&st.cond, parser);
+                    st.if_true = NULL;
+                    st.if_false = NULL;
                     statement.if_st = st;
                     prog->statement = statement;
                     break;
@@ -97,75 +139,157 @@ t_ast *parse_aux(const t_prog_token_list *list, unsigned int *i) {
                 case KW_WHILE: {
                     prog->command = While;
                     t_while_statement st;
-                    (*i)++;
-                    get_expr_rpn(&st.cond, list, i);
-                    st.block = parse_aux(list, i);
+                    parser->i++;
+                    get_expr_rpn(&st.cond, parser);
+                    st.block = NULL;
                     statement.while_st = st;
                     prog->statement = statement;
                     break;
                 }
-                case KW_ENDBLOCK: {
-                    (*i)++;
-                    prog->next = NULL;
-                    return NULL;
-                }
-                case KW_ELSE: {
-                    (*i)++;
-                    is_else = true;
-                    prog->next = NULL;
-                    return NULL;
-                }
-                case KW_FOR:
+                case KW_FOR: {
                     prog->command = For;
                     t_for_statement st;
-                    (*i)++;
-                    t_prog_token assign_token = ptl_get(list, *i+1);
-                    t_prog_token init_token = ptl_get(list, *i);
+                    parser->i++;
+                    if (parser->i + 1 >= list->size) {
+                        fprintf(error_stream(), "Expression expected\n");
+                        parser->error = true;
+                        break;
+                    }
+                    t_prog_token assign_token = ptl_get(list, parser->i + 1);
+                    t_prog_token init_token = ptl_get(list, parser->i);
                     if (assign_token.token_type != PT_KEYWORD) {
                         st.init_type = VAR;
                         st.init.var = init_token.content.var;
-                        (*i)++;
+                        parser->i++;
                     } else {
                         st.init_type = ASSIGNMENT;
                         t_assignment_statement st_assign;
                         st_assign.var = init_token.content.var;
-                        *i = *i+2;
-                        get_expr_rpn(&st_assign.expr, list, i);
+                        parser->i += 2;
+                        get_expr_rpn(&st_assign.expr, parser);
                         st.init.assignment = st_assign;
                     }
-                    get_expr_rpn(&st.cond, list, i);
-                    get_expr_rpn(&st.expr, list, i);
-                    st.block = parse_aux(list, i);
+                    get_expr_rpn(&st.cond, parser);
+                    get_expr_rpn(&st.expr, parser);
+                    st.block = NULL;
                     statement.for_st = st;
                     prog->statement = statement;
                     break;
+                }
                 default:
-                    printf("Syntax error: wrong keyword ");
-                    print_keyword(token.content.keyword);
-                    printf("\n");
+                    fprintf(error_stream(), "Syntax error: wrong keyword ");
+                    print_keyword_file(error_stream(), token.content.keyword);
+                    fprintf(error_stream(), "\n");
+                    parser->error = true;
                     break;
             }
             break;
         }
-        case PT_STRING:
-            break;
         default: {
-            printf("Syntax error: wrong token type\n");
+            fprintf(error_stream(), "Syntax error: wrong token type\n");
+            parser->error = true;
             break;
         }
     }
-    if (*i == (unsigned int) (-1)) {
-        //free(prog);
-        return NULL;
+    return parser->error ? NULL : prog;
+}
+
+// Ends the statement list on top of the stack, and attaches it to the statement owning it
+void close_statement_list(t_parser *parser) {
+    const t_parser_frame frame = parser->frames[--parser->nb_frames];
+    t_ast *owner = frame.owner;
+    switch (frame.type) {
+        case BLOCK_TOP:
+            return;
+        case BLOCK_IF_TRUE:
+            owner->statement.if_st.if_true = frame.head;
+            if (parser->is_else) {
+                parser->is_else = false;
+                push_parser_frame(parser, BLOCK_IF_FALSE, owner);
+                return;
+            }
+            break;
+        case BLOCK_IF_FALSE:
+            owner->statement.if_st.if_false = frame.head;
+            break;
+        case BLOCK_LOOP:
+            if (owner->command == While)
+                owner->statement.while_st.block = frame.head;
+            else
+                owner->statement.for_st.block = frame.head;
+            break;
     }
-    prog->next = parse_aux(list, i);
-    return prog;
+    append_statement(parser, owner);
+}
+
+bool parse_step(t_parser *parser) {
+
+    const t_prog_token_list *list = parser->list;
+    if (parser->nb_frames == 0)
+        return false;
+
+    // End of the program: every statement list still open ends here
+    if (parser->i >= list->size) {
+        if (parser->nb_frames == 1)
+            parser->top_level = parser->frames[0].head;
+        close_statement_list(parser);
+        return parser->nb_frames > 0;
+    }
+
+    const t_prog_token token = ptl_get(list, parser->i);
+    if (token.token_type == PT_KEYWORD
+        && (token.content.keyword == KW_ENDBLOCK || token.content.keyword == KW_ELSE)) {
+        parser->i++;
+        if (token.content.keyword == KW_ELSE)
+            parser->is_else = true;
+        if (parser->nb_frames == 1)
+            parser->top_level = parser->frames[0].head;
+        close_statement_list(parser);
+        return parser->nb_frames > 0;
+    }
+
+    t_ast *prog = parse_statement(parser);
+    if (parser->error) {
+        // The statements containing the error are dropped, the program stops before them
+        parser->top_level = parser->frames[0].head;
+        parser->nb_frames = 0;
+        return false;
+    }
+    switch (prog->command) {
+        case If:
+            push_parser_frame(parser, BLOCK_IF_TRUE, prog);
+            break;
+        case While:
+        case For:
+            push_parser_frame(parser, BLOCK_LOOP, prog);
+            break;
+        default:
+            append_statement(parser, prog);
+            break;
+    }
+    return true;
 }
 
-t_ast *parse(const t_prog_token_list *list) {
+t_ast *parse_program(t_parser *parser) {
+    push_parser_frame(parser, BLOCK_TOP, NULL);
+    while (parse_step(parser)) {
+    }
+    return parser->top_level;
+}
+
+void destroy_parser(t_parser *parser) {
+    free(parser->frames);
+    parser->frames = NULL;
+    parser->nb_frames = 0;
+    parser->capacity = 0;
+}
+
+t_ast *parse(const t_prog_token_list *list, t_arena *arena) {
 
     if (list->size == 0) return NULL;
 
-    unsigned int i = 0; // index in the list
-    return parse_aux(list, &i);
-}
\ No newline at end of file
+    t_parser parser = create_parser(list, arena);
+    t_ast *prog = parse_program(&parser);
+    destroy_parser(&parser);
+    return prog;
+}
@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <time.h>
+
+#include "program/profile.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <x86intrin.h>
+#endif
+
+t_profile *run_profile = NULL;
+
+#if defined(__x86_64__) && defined(__GNUC__)
+const char *const profile_tick_unit = "cycles";
+
+// Time-stamp counter: about 20 cycles, not serializing, enough for the time of a statement
+uint64_t profile_ticks() {
+    return __rdtsc();
+}
+#else
+const char *const profile_tick_unit = "ns";
+
+uint64_t profile_ticks() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+}
+#endif
+
+// Numbers the statements of the list and of its blocks, in the order of the program
+void number_profile_nodes(t_profile *profile, t_ast *list, const int parent, int *capacity) {
+    for (t_ast *node = list; node != NULL; node = node->next) {
+        if (profile->nb_nodes >= *capacity) {
+            *capacity *= 2;
+            profile->nodes = realloc(profile->nodes, *capacity * sizeof(t_node_profile));
+        }
+        const int id = profile->nb_nodes++;
+        node->profile_id = id;
+        profile->nodes[id] = (t_node_profile) { .node = node, .parent = parent };
+        switch (node->command) {
+            case If:
+                number_profile_nodes(profile, node->statement.if_st.if_true, id, capacity);
+                number_profile_nodes(profile, node->statement.if_st.if_false, id, capacity);
+                break;
+            case While:
+                number_profile_nodes(profile, node->statement.while_st.block, id, capacity);
+                break;
+            case For:
+                number_profile_nodes(profile, node->statement.for_st.block, id, capacity);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void init_profile(t_profile *profile, t_ast *prog) {
+    int capacity = 64;
+    profile->nodes = malloc(capacity * sizeof(t_node_profile));
+    profile->nb_nodes = 0;
+    number_profile_nodes(profile, prog, -1, &capacity);
+    profile->current = -1;
+    profile->total_ticks = 0;
+    profile->last_tick = profile_ticks();
+}
+
+// Expressions evaluated when the statement is reached, or when a loop evaluates its condition again
+int evaluated_expressions(const t_ast *node, const bool again) {
+    switch (node->command) {
+        case Print:
+            return node->statement.print_st.expr_type == RPN;
+        case For:
+            // The step then the condition, or the initialization then the condition
+            return again || node->statement.for_st.init_type == ASSIGNMENT ? 2 : 1;
+        default:
+            return 1;
+    }
+}
+
+void profile_statement(t_profile *profile, const t_ast *node, const bool again) {
+    const uint64_t now = profile_ticks();
+    if (profile->current >= 0)
+        profile->nodes[profile->current].ticks += now - profile->last_tick;
+    profile->last_tick = now;
+    profile->current = node->profile_id;
+    t_node_profile *node_profile = &profile->nodes[node->profile_id];
+    node_profile->count++;
+    node_profile->evals += evaluated_expressions(node, again);
+}
+
+void profile_taken(t_profile *profile, const t_ast *node) {
+    profile->nodes[node->profile_id].taken++;
+}
+
+void finish_profile(t_profile *profile) {
+    if (profile->current >= 0)
+        profile->nodes[profile->current].ticks += profile_ticks() - profile->last_tick;
+    profile->current = -1;
+    profile->total_ticks = 0;
+    for (int i = 0; i < profile->nb_nodes; i++)
+        profile->total_ticks += profile->nodes[i].ticks;
+}
+
+uint64_t profile_list_exits(const t_profile *profile, const t_ast *list) {
+    if (list == NULL)
+        return 0;
+    while (list->next != NULL)
+        list = list->next;
+    const t_node_profile *last = &profile->nodes[list->profile_id];
+    switch (list->command) {
+        case Return:
+            return 0;
+        case If: {
+            const t_if_statement *st = &list->statement.if_st;
+            // Without else, the false conditions go on directly
+            const uint64_t else_exits = st->if_false != NULL ? profile_list_exits(profile, st->if_false)
+                                                             : last->count - last->taken;
+            return profile_list_exits(profile, st->if_true) + else_exits;
+        }
+        case While:
+        case For:
+            return last->count - last->taken;
+        default:
+            return last->count;
+    }
+}
+
+// Order of the report: the most expensive statement first
+int compare_node_profiles(const void *a, const void *b) {
+    const t_node_profile *x = *(const t_node_profile *const *) a;
+    const t_node_profile *y = *(const t_node_profile *const *) b;
+    if (x->ticks != y->ticks)
+        return x->ticks < y->ticks ? 1 : -1;
+    return x->node->profile_id - y->node->profile_id;
+}
+
+void print_profile_report(FILE *file, const t_profile *profile) {
+    // Time with the blocks: each statement adds its time to the statements that hold it (the parents come first)
+    uint64_t *inclusive = malloc((profile->nb_nodes + 1) * sizeof(uint64_t));
+    const t_node_profile **sorted = malloc((profile->nb_nodes + 1) * sizeof(t_node_profile *));
+    for (int i = 0; i < profile->nb_nodes; i++) {
+        inclusive[i] = profile->nodes[i].ticks;
+        sorted[i] = &profile->nodes[i];
+    }
+    for (int i = profile->nb_nodes - 1; i >= 0; i--) {
+        if (profile->nodes[i].parent >= 0)
+            inclusive[profile->nodes[i].parent] += inclusive[i];
+    }
+    qsort(sorted, profile->nb_nodes, sizeof(t_node_profile *), compare_node_profiles);
+
+    fprintf(file, "%d statements, %llu %s\n", profile->nb_nodes, (unsigned long long) profile->total_ticks,
+            profile_tick_unit);
+    fprintf(file, "%7s %14s %14s %12s %12s %12s %10s  %s\n", "self %", "self", "total", "executions", "taken",
+            "evaluations", "per exec", "statement");
+    for (int i = 0; i < profile->nb_nodes; i++) {
+        const t_node_profile *p = sorted[i];
+        const int id = p->node->profile_id;
+        const double share = profile->total_ticks == 0 ? 0 : 100.0 * p->ticks / profile->total_ticks;
+        fprintf(file, "%6.2f%% %14llu %14llu %12llu %12llu %12llu %10.1f  #%d ", share,
+                (unsigned long long) p->ticks, (unsigned long long) inclusive[id], (unsigned long long) p->count,
+                (unsigned long long) p->taken, (unsigned long long) p->evals,
+                p->count == 0 ? 0.0 : (double) p->ticks / p->count, id);
+        print_prog_node(file, p->node);
+        fprintf(file, "\n");
+    }
+    free(sorted);
+    free(inclusive);
+}
+
+void destroy_profile(t_profile *profile) {
+    free(profile->nodes);
+    profile->nodes = NULL;
+    profile->nb_nodes = 0;
+}
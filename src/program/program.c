@@ -1,8 +1,6 @@
 #include "program/program.h"
-#include "structures/prog_token_list.h"
-#include "program/lexer.h"
-#include "program/parser.h"
-#include "program/run.h"
+#include "program/compilation.h"
+#include "program/profile.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -39,7 +37,7 @@ void print_prog_node(FILE *file, const t_ast *prog) {
             const t_return_statement *st = &prog->statement.return_st;
             e = &st->expr;
             fprintf(file, "Return (");
-            print_expr_file(file, &e->expr);
+            print_expr_rpn_file(file, e);
             fprintf(file, ")");
             break;
         }
@@ -53,22 +51,23 @@ void print_prog_node(FILE *file, const t_ast *prog) {
             }
             e = &st->expr;
             fprintf(file, "Print (");
-            print_expr_file(file, &e->expr);
+            print_expr_rpn_file(file, e);
             fprintf(file, ")");
             break;
         }
         case Assignment: {
             const t_assignment_statement *st = &prog->statement.assignment_st;
             e = &st->expr;
-            fprintf(file, "%c ← ", st->var);
-            print_expr_file(file, &e->expr);
+            print_variable_file(file, (unsigned char) st->var - 'a');
+            fprintf(file, " ← ");
+            print_expr_rpn_file(file, e);
             break;
         }
         case If: {
             const t_if_statement *st = &prog->statement.if_st;
             e = &st->cond;
             fprintf(file, "If (");
-            print_expr_file(file, &e->expr);
+            print_expr_rpn_file(file, e);
             fprintf(file, ")");
             break;
         }
@@ -76,7 +75,7 @@ void print_prog_node(FILE *file, const t_ast *prog) {
             const t_while_statement *st = &prog->statement.while_st;
             e = &st->cond;
             fprintf(file, "While (");
-            print_expr_file(file, &e->expr);
+            print_expr_rpn_file(file, e);
             fprintf(file, ")");
             break;
         }
@@ -86,249 +85,224 @@ void print_prog_node(FILE *file, const t_ast *prog) {
             char var;
             if (st->init_type == VAR) {
                 var = st->init.var;
-                fprintf(file, "%s", &st->init.var);
+                fprintf(file, "%c", st->init.var);
             } else {
                 const t_assignment_statement *assignment = &st->init.assignment;
                 var = assignment->var;
                 fprintf(file, "%c ← ", assignment->var);
-                print_expr_file(file, &assignment->expr.expr);
+                print_expr_rpn_file(file, &assignment->expr);
             }
             fprintf(file, ", ");
-            print_expr_file(file, &st->cond.expr);
+            print_expr_rpn_file(file, &st->cond);
             fprintf(file, ", %c ← ", var);
-            print_expr_file(file, &st->expr.expr);
+            print_expr_rpn_file(file, &st->expr);
             fprintf(file, ")");
             break;
         }
     }
 }
 
-// Returns true if the current program stops (reaches a final state)
-bool print_mermaid_aux(FILE *file, const t_ast *prog, int *cpt) {
-    if (prog == NULL)
-        return false;
-
-    const int current_index = *cpt;
+// Heat of a statement in the annotated graph: its share of the time of the program, from cold (0) to hot (4)
+int profile_heat(const t_profile *profile, const t_ast *node) {
+    if (profile->total_ticks == 0)
+        return 0;
+    const double share = (double) profile->nodes[node->profile_id].ticks / profile->total_ticks;
+    return share < 0.01 ? 0 : share < 0.05 ? 1 : share < 0.15 ? 2 : share < 0.4 ? 3 : 4;
+}
 
-//#define FLOWCHART
+// Prints the edge from A<from> to A<to>, with its label (NULL if none) and, with a profile, the number of times the
+// execution followed it
+void print_mermaid_edge(FILE *file, const int from, const int to, const char *label, const t_profile *profile,
+                        const uint64_t count) {
 #ifdef FLOWCHART
-    fprintf(file, "\tA%d[\"", current_index);
-    print_prog_node(file, prog);
-    fprintf(file, "\"]\n");
+    if (label == NULL && profile == NULL) {
+        fprintf(file, "\tA%d --> A%d\n", from, to);
+        return;
+    }
+    fprintf(file, "\tA%d -- ", from);
 #else
-    fprintf(file, "\tA%d: ", current_index);
-    print_prog_node(file, prog);
-    fprintf(file, "\n");
+    if (label == NULL && profile == NULL) {
+        fprintf(file, "\tA%d --> A%d\n", from, to);
+        return;
+    }
+    fprintf(file, "\tA%d --> A%d: ", from, to);
 #endif
-
-    switch (prog->command) {
-        case Return:
-            fprintf(file, "\tA%d --> [*]\n", current_index);
-            return true;
-        case Print:
-        case Assignment: {
-            if (prog->next != NULL) {
-                (*cpt)++;
-                const int next_token_index = *cpt;
-                fprintf(file, "\tA%d --> A%d\n", current_index, next_token_index);
-            }
-            break;
-        }
-        case If: {
-            const t_if_statement *st = &prog->statement.if_st;
-            (*cpt)++;
-            const int cpt_if_true = *cpt;
-            int cpt_if_false;
+    if (label != NULL)
+        fprintf(file, "%s%s", label, profile != NULL ? " " : "");
+    if (profile != NULL)
+        fprintf(file, "%llu", (unsigned long long) count);
 #ifdef FLOWCHART
-            fprintf(file, "\tA%d -- then --> A%d\n", current_index, cpt_if_true);
-#else
-            fprintf(file, "\tA%d --> A%d: then\n", current_index, cpt_if_true);
+    fprintf(file, " --> A%d", to);
 #endif
-            const bool then_final = print_mermaid_aux(file, st->if_true, cpt);
-            bool else_final;
-            const int index_ret_true = *cpt;
-            int index_ret_else;
+    fprintf(file, "\n");
+}
 
-            if (st->if_false != NULL) {
-                (*cpt)++;
-                cpt_if_false = *cpt;
-#ifdef FLOWCHART
-                fprintf(file, "\tA%d -- else --> A%d\n", current_index, cpt_if_false);
-#else
-                fprintf(file, "\tA%d --> A%d: else\n", current_index, cpt_if_false);
-#endif
-                else_final = print_mermaid_aux(file, st->if_false, cpt);
-                index_ret_else = *cpt;
-            }
-            (*cpt)++;
-            const int next_token_index = *cpt;//((st->if_false != NULL) && (then_final || else_final)) ? *cpt + 1 : *cpt;
-            //if (prog->next == NULL && (!then_final && !else_final)) {
+// Returns true if the current program stops (reaches a final state)
+// The statements of a list are printed in a loop, only nested blocks are printed recursively
+// With a profile, the statements show their executions and their share of the time, the edges how many times they
+// were followed
+bool print_mermaid_aux(FILE *file, const t_ast *prog, int *cpt, const t_profile *profile) {
+    for (; prog != NULL; prog = prog->next) {
+        const int current_index = *cpt;
+        const t_node_profile *node_profile = profile != NULL ? &profile->nodes[prog->profile_id] : NULL;
+
+//#define FLOWCHART
 #ifdef FLOWCHART
-                fprintf(file, "\tA%d[\" \"]\n", next_token_index);
+        fprintf(file, "\tA%d[\"", current_index);
+        print_prog_node(file, prog);
 #else
-                fprintf(file, "\tstate A%d <<choice>>\n", next_token_index);
+        fprintf(file, "\tA%d: ", current_index);
+        print_prog_node(file, prog);
 #endif
-            //}
-            if (!then_final)
-                fprintf(file, "\tA%d --> A%d\n", index_ret_true, next_token_index);
-            if (st->if_false != NULL && !else_final)
-                fprintf(file, "\tA%d --> A%d\n", index_ret_else, next_token_index);
-            else {
-                if (st->if_false == NULL) {
+        if (profile != NULL) {
+            fprintf(file, " — #%d, %llu ×, %.1f %%", prog->profile_id, (unsigned long long) node_profile->count,
+                    profile->total_ticks == 0 ? 0.0 : 100.0 * node_profile->ticks / profile->total_ticks);
+        }
 #ifdef FLOWCHART
-                    fprintf(file, "\tA%d -- else --> A%d\n", current_index, next_token_index);
+        fprintf(file, "\"]\n");
 #else
-                    fprintf(file, "\tA%d --> A%d: else\n", current_index, next_token_index);
+        fprintf(file, "\n");
 #endif
+        if (profile != NULL)
+            fprintf(file, "\tclass A%d heat%d\n", current_index, profile_heat(profile, prog));
+
+        switch (prog->command) {
+            case Return:
+                if (profile != NULL)
+                    fprintf(file, "\tA%d --> [*]: %llu\n", current_index, (unsigned long long) node_profile->count);
+                else
+                    fprintf(file, "\tA%d --> [*]\n", current_index);
+                return true;
+            case Print:
+            case Assignment: {
+                if (prog->next != NULL) {
+                    (*cpt)++;
+                    const int next_token_index = *cpt;
+                    print_mermaid_edge(file, current_index, next_token_index, NULL, profile,
+                                       profile != NULL ? node_profile->count : 0);
                 }
+                break;
             }
-            break;
-        }
-        case While: {
-            const t_while_statement *st = &prog->statement.while_st;
-            (*cpt)++;
-            fprintf(file, "\tA%d --> A%d: then\n", current_index, *cpt);
-            print_mermaid_aux(file, st->block, cpt);
-            const int index_ret_block = *cpt;
-            fprintf(file, "\tA%d --> A%d\n", index_ret_block, current_index);
-            (*cpt)++;
-            const int next_token = *cpt;
-            fprintf(file, "\tA%d --> A%d: next\n", current_index, next_token);
-            break;
-        }
-        case For: {
-            const t_for_statement *st = &prog->statement.for_st;
-            (*cpt)++;
-            // then = beginning of the block
-#ifdef FLOWCHART
-            fprintf(file, "\tA%d -- then --> A%d\n", current_index, *cpt);
-#else
-            fprintf(file, "\tA%d --> A%d: then\n", current_index, *cpt);
-#endif
-            // print the block
-            print_mermaid_aux(file, st->block, cpt);
-            const int index_ret_block = *cpt;
-            // after the block, go back to the for condition (current_index)
-#ifdef FLOWCHART
-            fprintf(file, "\tA%d --> A%d\n", index_ret_block, current_index);
-#else
-            fprintf(file, "\tA%d --> A%d\n", index_ret_block, current_index);
-#endif
-            // node after the loop
-            (*cpt)++;
-            const int next_token = *cpt;
+            case If: {
+                const t_if_statement *st = &prog->statement.if_st;
+                const uint64_t taken = profile != NULL ? node_profile->taken : 0;
+                const uint64_t not_taken = profile != NULL ? node_profile->count - taken : 0;
+                (*cpt)++;
+                const int cpt_if_true = *cpt;
+                int cpt_if_false;
+                print_mermaid_edge(file, current_index, cpt_if_true, "then", profile, taken);
+                const bool then_final = print_mermaid_aux(file, st->if_true, cpt, profile);
+                bool else_final;
+                const int index_ret_true = *cpt;
+                int index_ret_else;
+
+                if (st->if_false != NULL) {
+                    (*cpt)++;
+                    cpt_if_false = *cpt;
+                    print_mermaid_edge(file, current_index, cpt_if_false, "else", profile, not_taken);
+                    else_final = print_mermaid_aux(file, st->if_false, cpt, profile);
+                    index_ret_else = *cpt;
+                }
+                (*cpt)++;
+                const int next_token_index = *cpt;//((st->if_false != NULL) && (then_final || else_final)) ? *cpt + 1 : *cpt;
+                //if (prog->next == NULL && (!then_final && !else_final)) {
 #ifdef FLOWCHART
-            fprintf(file, "\tA%d -- next --> A%d\n", current_index, next_token);
+                    fprintf(file, "\tA%d[\" \"]\n", next_token_index);
 #else
-            fprintf(file, "\tA%d --> A%d: next\n", current_index, next_token);
+                    fprintf(file, "\tstate A%d <<choice>>\n", next_token_index);
 #endif
-            break;
+                //}
+                if (!then_final)
+                    print_mermaid_edge(file, index_ret_true, next_token_index, NULL, profile,
+                                       profile != NULL ? profile_list_exits(profile, st->if_true) : 0);
+                if (st->if_false != NULL && !else_final)
+                    print_mermaid_edge(file, index_ret_else, next_token_index, NULL, profile,
+                                       profile != NULL ? profile_list_exits(profile, st->if_false) : 0);
+                else {
+                    if (st->if_false == NULL)
+                        print_mermaid_edge(file, current_index, next_token_index, "else", profile, not_taken);
+                }
+                break;
+            }
+            case While:
+            case For: {
+                const t_ast *block = prog->command == While ? prog->statement.while_st.block
+                                                            : prog->statement.for_st.block;
+                (*cpt)++;
+                // then = beginning of the block
+                print_mermaid_edge(file, current_index, *cpt, "then", profile,
+                                   profile != NULL ? node_profile->taken : 0);
+                // print the block
+                print_mermaid_aux(file, block, cpt, profile);
+                const int index_ret_block = *cpt;
+                // after the block, go back to the condition (current_index)
+                print_mermaid_edge(file, index_ret_block, current_index, NULL, profile,
+                                   profile != NULL ? profile_list_exits(profile, block) : 0);
+                // node after the loop
+                (*cpt)++;
+                const int next_token = *cpt;
+                print_mermaid_edge(file, current_index, next_token, "next", profile,
+                                   profile != NULL ? node_profile->count - node_profile->taken : 0);
+                break;
+            }
         }
     }
-    return print_mermaid_aux(file, prog->next, cpt);
+    return false;
 }
 
-// Generates a Mermaid graph representing the tree
-void print_ast(const t_ast *prog, const char *file_name) {
+// Writes the Mermaid graph of the program, annotated with the profile if it is not NULL
+void print_mermaid_file(const t_ast *prog, const t_profile *profile, const char *file_name) {
     FILE *file = fopen(file_name, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error: cannot write %s\n", file_name);
+        return;
+    }
     int cpt = 0;
 #ifdef FLOWCHART
     fprintf(file, "flowchart TD\n");
 #else
     fprintf(file, "stateDiagram\n");
+#endif
+    if (profile != NULL) {
+        // From cold to hot
+        static const char *const heat_colors[] = { "#f7f7f7", "#fee391", "#fec44f", "#fe9929", "#d7301f" };
+        for (int heat = 0; heat < 5; heat++)
+            fprintf(file, "\tclassDef heat%d fill:%s\n", heat, heat_colors[heat]);
+    }
+#ifndef FLOWCHART
     cpt++;
-    fprintf(file, "\t[*] --> A%d\n", cpt);
+    if (profile != NULL)
+        fprintf(file, "\t[*] --> A%d: 1\n", cpt);
+    else
+        fprintf(file, "\t[*] --> A%d\n", cpt);
 #endif
-    print_mermaid_aux(file, prog, &cpt);
+    print_mermaid_aux(file, prog, &cpt, profile);
     fclose(file);
-    printf("AST exported as %s\n", file_name);
+    // The profile is announced on stderr by its caller, after the output of the program
+    if (profile == NULL)
+        printf("AST exported as %s\n", file_name);
 }
 
-void run_program(const char *s) {
-    t_prog_token_list list = lex(s);
-
-    t_ast *prog = parse(&list);
-    ptl_destroy_list(&list);
-
-    run(prog);
-    
-    destroy_ast(prog);
+// Generates a Mermaid graph representing the tree
+void print_ast(const t_ast *prog, const char *file_name) {
+    print_mermaid_file(prog, NULL, file_name);
 }
 
-
-void export_program_ast(const char *s, const char *source_file_name) {
-    t_prog_token_list list = lex(s);
-    t_ast *prog = parse(&list);
-    ptl_destroy_list(&list);
-
-    const int len = strlen(source_file_name);
-    char file_name[1000];
-    strncpy(file_name, source_file_name, len);
-    char *ext = file_name + len - (len >= 5 && source_file_name[len - 4] == '.' ? 4 : 0);
-    strcpy(ext, ".mmd");
-    ext[4] = '\0';
-
-    print_ast(prog, file_name);
-    destroy_ast(prog);
+void print_ast_profile(const t_ast *prog, const t_profile *profile, const char *file_name) {
+    print_mermaid_file(prog, profile, file_name);
 }
 
+void run_program(const char *s, const t_run_options *options) {
+    t_program *program = compile_program(s, strlen(s), options->lex_threads);
+    if (options->mem_stats)
+        print_arena_stats(stderr, &program->arena);
+    run_compiled_program(program, options);
+    destroy_program(program);
+}
 
-//////////////////////////////////////////////////////////////////////////
-
-void destroy_statement(const e_statement_type type, u_statement *statement) {
-    if (statement == NULL)
-        return;
 
-    switch (type) {
-        case Assignment: {
-            t_assignment_statement *st = &statement->assignment_st;
-            destroy_expr_rpn(&st->expr);
-            break;
-        }
-        case Return: {
-            t_return_statement *st = &statement->return_st;
-            destroy_expr_rpn(&st->expr);
-            break;
-        }
-        case Print: {
-            t_print_statement *st = &statement->print_st;
-            if (st->expr_type == RPN)
-                destroy_expr_rpn(&st->expr);
-            else
-                destroy_expr(&st->string);
-            break;
-        }
-        case If: {
-            t_if_statement *st = &statement->if_st;
-            destroy_expr_rpn(&st->cond);
-            destroy_ast(st->if_true);
-            destroy_ast(st->if_false);
-            break;
-        }
-        case While: {
-            t_while_statement *st = &statement->while_st;
-            destroy_expr_rpn(&st->cond);
-            destroy_ast(st->block);
-            break;
-        }
-        case For: {
-            t_for_statement *st = &statement->for_st;
-            if (st->init_type == ASSIGNMENT) {
-                destroy_expr_rpn(&st->init.assignment.expr);
-            }
-            destroy_expr_rpn(&st->cond);
-            destroy_expr_rpn(&st->expr);
-            destroy_ast(st->block);
-            break;
-        }
-    }
+void export_program_ast(const char *s, const char *source_file_name) {
+    t_program *program = compile_program_exported(s, strlen(s), 1);
+    export_compiled_program(program, source_file_name);
+    destroy_program(program);
 }
-
-void destroy_ast(t_ast *prog) {
-    if (prog == NULL)
-        return;
-    destroy_statement(prog->command, &prog->statement);
-    destroy_ast(prog->next);
-    prog->next = nullptr;
-    free(prog);
-}
\ No newline at end of file
@@ -3,85 +3,215 @@
 #include <stdlib.h>
 
 #include "program/program.h"
+#include "program/error.h"
+#include "program/profile.h"
 
-// Recursive function, evaluates the program
+// Statement whose block is being executed, and what to do when the block ends
+typedef enum {
+    FRAME_IF,       // continue after the if statement
+    FRAME_WHILE,    // evaluate the condition again
+    FRAME_FOR       // evaluate the step, then the condition again
+} e_frame_type;
+
+typedef struct {
+    e_frame_type type;
+    const t_ast *node;
+} t_frame;
+
+// Control stack: its size is the nesting depth of the blocks, not the length of the program
+typedef struct {
+    t_frame *data;
+    int size;
+    int capacity;
+} t_control_stack;
+
+#define INIT_CAPACITY 16
+
+void push_frame(t_control_stack *stack, const e_frame_type type, const t_ast *node) {
+    if (stack->size >= stack->capacity) {
+        stack->capacity = stack->capacity == 0 ? INIT_CAPACITY : 2 * stack->capacity;
+        stack->data = realloc(stack->data, stack->capacity * sizeof(t_frame));
+    }
+    stack->data[stack->size].type = type;
+    stack->data[stack->size].node = node;
+    stack->size++;
+}
+
+// Iterative function, evaluates the program
+// Statements of a list are executed in a loop, entering a block pushes a frame on the control stack
+// print and return write their output in out, stack is the control stack (empty at the start)
 // Returns true if a Return statement was reached, stop the execution
-// Returns false if the end of a block was reached
-bool run_aux(int var_value[], const t_ast *prog) {
+// Returns false if the end of the program was reached
+bool run_aux(int var_value[], const t_ast *prog, FILE *out, t_control_stack *stack) {
 
-    if (prog == NULL)
-        return false;
+    bool returned = false;
 
-    switch (prog->command) {
-        case Return: {
-            const t_return_statement st = prog->statement.return_st;
-            fprintf(stdout, "-> %d\n", eval_rpn(var_value, &st.expr));
-            return true;
-        }
-        case Assignment: {
-            const t_assignment_statement st = prog->statement.assignment_st;
-            var_value[(unsigned char)st.var - 'a'] = eval_rpn(var_value, &st.expr);
-            break;
+    while (true) {
+        // End of a block: go back to the statement that owns it
+        if (prog == NULL) {
+            if (stack->size == 0)
+                break;
+            const t_frame frame = stack->data[--stack->size];
+            switch (frame.type) {
+                case FRAME_IF:
+                    prog = frame.node->next;
+                    break;
+                case FRAME_WHILE: {
+                    const t_while_statement *st = &frame.node->statement.while_st;
+                    if (run_profile != NULL)
+                        profile_statement(run_profile, frame.node, true);
+                    if (eval_rpn(var_value, &st->cond)) {
+                        if (run_profile != NULL)
+                            profile_taken(run_profile, frame.node);
+                        push_frame(stack, FRAME_WHILE, frame.node);
+                        prog = st->block;
+                    } else {
+                        prog = frame.node->next;
+                    }
+                    break;
+                }
+                case FRAME_FOR: {
+                    const t_for_statement *st = &frame.node->statement.for_st;
+                    if (run_profile != NULL)
+                        profile_statement(run_profile, frame.node, true);
+                    const char var = st->init_type == VAR ? st->init.var : st->init.assignment.var;
+                    var_value[(unsigned char)var - 'a'] = eval_rpn(var_value, &st->expr);
+                    if (eval_rpn(var_value, &st->cond)) {
+                        if (run_profile != NULL)
+                            profile_taken(run_profile, frame.node);
+                        push_frame(stack, FRAME_FOR, frame.node);
+                        prog = st->block;
+                    } else {
+                        prog = frame.node->next;
+                    }
+                    break;
+                }
+            }
+            continue;
         }
-        case Print: {
-            const t_print_statement st = prog->statement.print_st;
-            if (st.expr_type == RPN) {
-                fprintf(stdout, "%d\n", eval_rpn(var_value, &st.expr));
+
+        if (run_profile != NULL)
+            profile_statement(run_profile, prog, false);
+        switch (prog->command) {
+            case Return: {
+                const t_return_statement *st = &prog->statement.return_st;
+                fprintf(out, "-> %d\n", eval_rpn(var_value, &st->expr));
+                returned = true;
+                break;
             }
-            if (st.expr_type == STR) {
-                fprintf(stdout, "%s\n", eval_string_expr(&st.string));
+            case Assignment: {
+                const t_assignment_statement *st = &prog->statement.assignment_st;
+                const int slot = (unsigned char)st->var - 'a';
+                const t_expr_rpn *expr = &st->expr;
+                // Superinstruction x = x + c, x = x - c: the variable is updated in place
+                if ((expr->super == SUPER_ID(SHAPE_VAR_OP_CONST, ADD) || expr->super == SUPER_ID(SHAPE_VAR_OP_CONST, SUB))
+                    && expr->code[0].arg.slot == slot) {
+                    if (super_stats_enabled)
+                        super_hits[SUPER_ID(SHAPE_UPDATE, expr->code[2].arg.op)]++;
+                    const int c = expr->code[1].arg.val;
+                    var_value[slot] = expr->code[2].arg.op == ADD ? var_value[slot] + c : var_value[slot] - c;
+                } else {
+                    var_value[slot] = eval_rpn(var_value, expr);
+                }
+                prog = prog->next;
+                break;
             }
-            break;
-        }
-        case If: {
-            const t_if_statement st = prog->statement.if_st;
-            bool if_res = false;
-            if (eval_rpn(var_value, &st.cond)) {
-                if_res = run_aux(var_value, st.if_true);
-            } else {
-                if_res = run_aux(var_value, st.if_false);
+            case Print: {
+                const t_print_statement *st = &prog->statement.print_st;
+                if (st->expr_type == RPN) {
+                    fprintf(out, "%d\n", eval_rpn(var_value, &st->expr));
+                }
+                if (st->expr_type == STR) {
+                    fprintf(out, "%s\n", eval_string_expr(&st->string));
+                }
+                prog = prog->next;
+                break;
             }
-            if (if_res) return true;
-            break;
-        }
-        case While: {
-            const t_while_statement st = prog->statement.while_st;
-            bool while_res = false;
-            while (eval_rpn(var_value, &st.cond)) {
-                while_res = run_aux(var_value, st.block);
-                if (while_res) return true;
+            case If: {
+                const t_if_statement *st = &prog->statement.if_st;
+                push_frame(stack, FRAME_IF, prog);
+                if (eval_rpn(var_value, &st->cond)) {
+                    if (run_profile != NULL)
+                        profile_taken(run_profile, prog);
+                    prog = st->if_true;
+                } else {
+                    prog = st->if_false;
+                }
+                break;
             }
-            break;
-        }
-        case For: {
-            const t_for_statement st = prog->statement.for_st;
-            const char var = st.init_type == VAR ? st.init.var : st.init.assignment.var;
-            if (st.init_type == ASSIGNMENT) {
-                var_value[(unsigned char)var - 'a'] = eval_rpn(var_value, &st.init.assignment.expr);
+            case While: {
+                const t_while_statement *st = &prog->statement.while_st;
+                if (eval_rpn(var_value, &st->cond)) {
+                    if (run_profile != NULL)
+                        profile_taken(run_profile, prog);
+                    push_frame(stack, FRAME_WHILE, prog);
+                    prog = st->block;
+                } else {
+                    prog = prog->next;
+                }
+                break;
             }
-            while (eval_rpn(var_value, &st.cond)) {
-                bool for_res = false;
-                for_res = run_aux(var_value, st.block);
-                if (for_res) return true;
-                var_value[(unsigned char)var - 'a'] = eval_rpn(var_value, &st.expr);
+            case For: {
+                const t_for_statement *st = &prog->statement.for_st;
+                if (st->init_type == ASSIGNMENT) {
+                    const char var = st->init.assignment.var;
+                    var_value[(unsigned char)var - 'a'] = eval_rpn(var_value, &st->init.assignment.expr);
+                }
+                if (eval_rpn(var_value, &st->cond)) {
+                    if (run_profile != NULL)
+                        profile_taken(run_profile, prog);
+                    push_frame(stack, FRAME_FOR, prog);
+                    prog = st->block;
+                } else {
+                    prog = prog->next;
+                }
+                break;
+            }
+            default: {
+                fprintf(error_stream(), "Syntax error, Unrecognize statement\n");
+                program_error();
             }
-            break;
         }
-        default: {
-            fprintf(stderr , "Syntax error, Unrecognize statement\n");
-            exit(EXIT_FAILURE);
+        if (returned)
+            break;
+    }
+
+    return returned;
+}
+
+bool run_statements(int var_value[], const t_ast *prog, FILE *out) {
+    // Allocated on the heap: still reachable if an error jumps out of run_aux
+    t_control_stack *const stack = malloc(sizeof(t_control_stack));
+    *stack = (t_control_stack) { .data = NULL, .size = 0, .capacity = 0 };
+
+    // If the error is recovered by the caller, the stack is released before jumping back to it
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    if (caller_recovery != NULL) {
+        if (setjmp(recovery) != 0) {
+            error_recovery = caller_recovery;
+            free(stack->data);
+            free(stack);
+            longjmp(*caller_recovery, 1);
         }
+        error_recovery = &recovery;
     }
-    return run_aux(var_value, prog->next);
+
+    const bool returned = run_aux(var_value, prog, out, stack);
+
+    error_recovery = caller_recovery;
+    free(stack->data);
+    free(stack);
+    return returned;
 }
 
-void run(const t_ast *prog) {
-    int var_value[26];
-    for (int i = 0; i < 26; i++) {
+void run(const t_ast *prog, FILE *out) {
+    int var_value[NB_SLOTS];
+    for (int i = 0; i < NB_SLOTS; i++) {
         var_value[i] = 0;
     }
-    run_aux(var_value, prog);
+    run_statements(var_value, prog, out);
     // for (int i = 0; i < 27; i++) {
     //     fprintf(stdout, "%d\n", var_value[i]);
     // }
-}
\ No newline at end of file
+}
@@ -0,0 +1,214 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "program/stream.h"
+#include "program/error.h"
+#include "program/lexer.h"
+#include "program/parser.h"
+#include "program/run.h"
+
+#define STREAM_READ_SIZE (64 * 1024)
+// Complete lines kept in the buffer after the line being lexed: a token can end after its own line
+#define STREAM_LOOKAHEAD_LINES 2
+// Tokens read by the longest statement: for ([var] = [expr]; [expr]; [expr])
+#define MAX_STATEMENT_TOKENS 6
+
+// Everything owned by the stream, on the heap: still reachable if an error jumps out of run_stream
+typedef struct {
+    int fd;
+    FILE *out;
+    char *buffer;           // source not lexed yet, from buffer[pos] to buffer[size], followed by a '\0'
+    size_t pos;
+    size_t size;
+    size_t capacity;
+    bool eof;
+    int read_error;         // errno of the read that failed, 0 if none
+    bool lexed;             // the whole source was lexed
+    t_lexer_state state;
+    t_prog_token_list tokens;   // tokens not parsed yet, from tokens.data[parser.i]
+    // Two generations of tokens and AST nodes: the current arena receives the new ones, the previous one
+    // is reset when none of its tokens are waiting to be parsed anymore
+    t_arena arenas[2];
+    int current;
+    int generation_start;   // first token allocated in the current arena
+    t_parser parser;
+    int var_value[NB_SLOTS];
+} t_stream;
+
+// Appends the next block of fd to the buffer, after moving the part not lexed yet to its start
+// The output is flushed first: when fd is a terminal or a pipe, the read can wait
+void read_stream(t_stream *stream) {
+    if (stream->pos > 0) {
+        memmove(stream->buffer, stream->buffer + stream->pos, stream->size - stream->pos);
+        stream->size -= stream->pos;
+        stream->pos = 0;
+    }
+    if (stream->capacity - stream->size < STREAM_READ_SIZE) {
+        stream->capacity = stream->size + STREAM_READ_SIZE;
+        stream->buffer = realloc(stream->buffer, stream->capacity + 1);
+    }
+    fflush(stream->out);
+    ssize_t n;
+    do {
+        n = read(stream->fd, stream->buffer + stream->size, STREAM_READ_SIZE);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        stream->eof = true;
+        stream->read_error = n < 0 ? errno : 0;
+    } else {
+        stream->size += n;
+    }
+    stream->buffer[stream->size] = '\0';
+}
+
+// Returns the end of the line starting at from (after its '\n'), 0 if the line is not complete in the buffer
+size_t line_end(const t_stream *stream, const size_t from) {
+    const char *newline = memchr(stream->buffer + from, '\n', stream->size - from);
+    return newline == NULL ? 0 : newline - stream->buffer + 1;
+}
+
+// Lexes the next line of the source
+void lex_next_line(t_stream *stream) {
+    // The line and the lines after it must be complete, or the end of the source reached
+    size_t end = 0;
+    while (true) {
+        end = line_end(stream, stream->pos);
+        size_t last = end;
+        for (int k = 0; k < STREAM_LOOKAHEAD_LINES && last != 0; k++) {
+            last = line_end(stream, last);
+        }
+        if (last != 0 || stream->eof)
+            break;
+        read_stream(stream);
+    }
+    if (end == 0)
+        end = stream->size;
+    if (stream->pos >= stream->size) {
+        stream->lexed = true;
+        return;
+    }
+
+    const char *s = stream->buffer + stream->pos;
+    const char *stop = lex_range(s, stream->buffer + end, &stream->state, &stream->arenas[stream->current],
+                                 &stream->tokens, NULL, NULL);
+    stream->pos = stop - stream->buffer;
+    // The lexer stops before the end of the line only at a '\0' or an EOF character: the source ends there
+    if (stop < stream->buffer + end)
+        stream->lexed = true;
+}
+
+// Number of tokens the parser reads to parse the statement starting with token
+int statement_tokens(const t_prog_token *token) {
+    if (token->token_type == PT_VAR)
+        return 3;
+    if (token->token_type != PT_KEYWORD)
+        return 1;
+    switch (token->content.keyword) {
+        case KW_FOR:
+            return MAX_STATEMENT_TOKENS;
+        case KW_PRINT:
+        case KW_RETURN:
+        case KW_IF:
+        case KW_WHILE:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// Lexes until the parser has every token of its next step, or the source ends
+void lex_next_statement(t_stream *stream) {
+    const t_parser *parser = &stream->parser;
+    while (!stream->lexed) {
+        const int available = stream->tokens.size - (int) parser->i;
+        if (available > 0 && available >= statement_tokens(&stream->tokens.data[parser->i]))
+            break;
+        lex_next_line(stream);
+    }
+}
+
+// The parser is back at the top level: the parsed tokens are dropped, and the previous arena is reset
+// once every token left was allocated in the current one
+void release_parsed(t_stream *stream) {
+    const int parsed = (int) stream->parser.i;
+    memmove(stream->tokens.data, stream->tokens.data + parsed, (stream->tokens.size - parsed) * sizeof(t_prog_token));
+    stream->tokens.size -= parsed;
+    stream->parser.i = 0;
+    stream->generation_start = stream->generation_start > parsed ? stream->generation_start - parsed : 0;
+
+    if (stream->generation_start == 0) {
+        stream->current = 1 - stream->current;
+        arena_reset(&stream->arenas[stream->current]);
+        stream->parser.arena = &stream->arenas[stream->current];
+        stream->generation_start = stream->tokens.size;
+    }
+}
+
+void destroy_stream(t_stream *stream) {
+    destroy_parser(&stream->parser);
+    ptl_destroy_list(&stream->tokens);
+    destroy_arena(&stream->arenas[0]);
+    destroy_arena(&stream->arenas[1]);
+    free(stream->buffer);
+    free(stream);
+}
+
+bool run_stream(const int fd, const t_run_options *options) {
+    t_stream *const stream = calloc(1, sizeof(t_stream));
+    stream->fd = fd;
+    stream->out = options->output != NULL ? options->output : stdout;
+    stream->capacity = STREAM_READ_SIZE;
+    stream->buffer = malloc(stream->capacity + 1);
+    stream->buffer[0] = '\0';
+    stream->state = lexer_initial_state();
+    stream->tokens = ptl_create_empty_list();
+    stream->arenas[0] = create_arena();
+    stream->arenas[1] = create_arena();
+    stream->parser = create_parser(&stream->tokens, &stream->arenas[0]);
+
+    // If the error is recovered by the caller, the stream is released before jumping back to it
+    jmp_buf *const caller_recovery = error_recovery;
+    jmp_buf recovery;
+    if (caller_recovery != NULL) {
+        if (setjmp(recovery) != 0) {
+            error_recovery = caller_recovery;
+            destroy_stream(stream);
+            longjmp(*caller_recovery, 1);
+        }
+        error_recovery = &recovery;
+    }
+
+    // Same steps as parse_program(), but every statement appended to the top level is executed at once
+    t_parser *parser = &stream->parser;
+    push_parser_frame(parser, BLOCK_TOP, NULL);
+    bool parsing = true;
+    while (parsing) {
+        lex_next_statement(stream);
+        parsing = parse_step(parser);
+
+        t_parser_frame *top = &parser->frames[0];
+        if (top->head != NULL) {
+            if (run_statements(stream->var_value, top->head, stream->out))
+                parsing = false;
+            top->head = NULL;
+            top->tail = NULL;
+        }
+        if (parsing && parser->nb_frames == 1)
+            release_parsed(stream);
+    }
+
+    error_recovery = caller_recovery;
+    if (options->mem_stats) {
+        for (int k = 0; k < 2; k++) {
+            print_arena_stats(stderr, &stream->arenas[k]);
+        }
+    }
+    const int read_error = stream->read_error;
+    if (read_error != 0)
+        fprintf(stderr, "Error: cannot read the program (%s)\n", strerror(read_error));
+    destroy_stream(stream);
+    return read_error == 0;
+}
@@ -0,0 +1,564 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "program/sweep.h"
+#include "file_io/file.h"
+#include "structures/task_pool.h"
+
+// Lanes of the vectors: the variables and the value stack of SWEEP_WIDTH runs, one run per lane
+// With the GCC vector extensions, a vector is one AVX2 register or two SSE registers; without them, the engine
+// has one lane and the same code runs one environment at a time
+#if defined(__GNUC__)
+#define SWEEP_WIDTH 8
+typedef int t_lanes __attribute__((vector_size(SWEEP_WIDTH * sizeof(int))));
+typedef unsigned t_ulanes __attribute__((vector_size(SWEEP_WIDTH * sizeof(int))));
+typedef double t_dlanes __attribute__((vector_size(SWEEP_WIDTH * sizeof(double))));
+typedef long long t_llanes __attribute__((vector_size(SWEEP_WIDTH * sizeof(long long))));
+#define LANE(v, l) ((v)[l])
+// Quotient truncated towards 0: a 32-bit quotient is exact in double, and a vector division exists for doubles only
+#define LANES_DIV(a, b) __builtin_convertvector(__builtin_convertvector(a, t_dlanes) / __builtin_convertvector(b, t_dlanes), t_lanes)
+// High half of the 64-bit products by the magic number of a division by a constant
+#define LANES_MULH(a, magic) __builtin_convertvector((__builtin_convertvector(a, t_llanes) * (magic)) >> 32, t_lanes)
+#else
+#define SWEEP_WIDTH 1
+typedef int t_lanes;
+typedef unsigned t_ulanes;
+#define LANE(v, l) (v)
+#define LANES_DIV(a, b) ((a) / (b))
+#define LANES_MULH(a, magic) ((int) (((long long) (a) * (magic)) >> 32))
+#endif
+
+// The same expressions on vectors and on ints: a comparison gives -1 in a vector and 1 in an int, & 1 gives 1
+#define LANES_ZERO ((t_lanes) {0})
+#define LANES_SPLAT(x) (LANES_ZERO + (x))
+#define LANES_WRAP(a, op, b) ((t_lanes) ((t_ulanes) (a) op (t_ulanes) (b)))
+#define LANES_TEST(a, op, b) (((a) op (b)) & 1)
+// All bits set in the lanes of the mask, whose lanes are 0 or 1
+#define LANES_FULL(mask) (LANES_ZERO - (mask))
+#define LANES_BLEND(full, a, b) (((full) & (a)) | (~(full) & (b)))
+
+// Computed-goto dispatch (GCC/Clang "labels as values"), switch dispatch otherwise, as in the VM
+#if defined(__GNUC__)
+#define SWEEP_COMPUTED_GOTO
+#endif
+
+#ifdef SWEEP_COMPUTED_GOTO
+#define SWEEP_CASE(opcode) L_##opcode:
+#define SWEEP_DISPATCH() goto *labels[code[pc].opcode]
+#else
+#define SWEEP_CASE(opcode) case opcode:
+#define SWEEP_DISPATCH() continue
+#endif
+
+// Next instruction of the active lanes, where they meet the first waiting lanes or not
+#define SWEEP_NEXT()                    \
+    {                                   \
+        if (++pc == next_wait)          \
+            goto reschedule;            \
+        SWEEP_DISPATCH();               \
+    }
+
+#define SWEEP_BINARY_OP(opcode, expr)                   \
+    SWEEP_CASE(opcode) {                                \
+        sp--;                                           \
+        const t_lanes a = sp[-1];                       \
+        const t_lanes b = *sp;                          \
+        sp[-1] = LANES_BLEND(full, (expr), a);          \
+        SWEEP_NEXT();                                   \
+    }
+
+// The generated code for the processor it runs on: AVX2 if it has it
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define SWEEP_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define SWEEP_TARGETS
+#endif
+
+// Output of one run
+typedef struct {
+    char *output;
+    size_t output_size;
+    bool error;             // the run stopped on a division by zero
+} t_sweep_run;
+
+typedef struct {
+    const t_bytecode *bc;
+    const int *depth;       // depth of the value stack before each instruction, the same on every path
+    const t_sweep_env *envs;
+    int nb_envs;
+    t_sweep_run *runs;
+} t_sweep;
+
+double sweep_elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+bool parse_sweep_env(const char *line, const char *end, t_sweep_env *env) {
+    env->assigned = 0;
+    for (int slot = 0; slot < NB_VARIABLES; slot++)
+        env->value[slot] = 0;
+    const char *p = line;
+    while (p < end) {
+        if (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r') {
+            p++;
+            continue;
+        }
+        if (*p < 'a' || *p > 'z')
+            return false;
+        const int slot = *p++ - 'a';
+        while (p < end && *p == ' ')
+            p++;
+        if (p == end || *p++ != '=')
+            return false;
+        while (p < end && *p == ' ')
+            p++;
+        const bool negative = p < end && *p == '-';
+        if (negative)
+            p++;
+        if (p == end || *p < '0' || *p > '9')
+            return false;
+        unsigned value = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+            value = 10 * value + (*p++ - '0');
+        env->value[slot] = (int) (negative ? 0u - value : value);
+        env->assigned |= (uint64_t) 1 << slot;
+    }
+    return env->assigned != 0;
+}
+
+bool load_sweep_envs(const char *file_name, t_sweep_env **envs, int *nb_envs) {
+    t_source source;
+    if (!load_source(file_name, &source))
+        return false;
+    int capacity = 64;
+    *envs = malloc(capacity * sizeof(t_sweep_env));
+    *nb_envs = 0;
+    const char *line = source.data;
+    const char *const data_end = source.data + source.size;
+    for (int line_number = 1; line < data_end; line_number++) {
+        const char *end = memchr(line, '\n', data_end - line);
+        if (end == NULL)
+            end = data_end;
+        const char *p = line;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+            p++;
+        if (p < end) {
+            if (*nb_envs >= capacity) {
+                capacity *= 2;
+                *envs = realloc(*envs, capacity * sizeof(t_sweep_env));
+            }
+            if (!parse_sweep_env(line, end, &(*envs)[*nb_envs])) {
+                fprintf(stderr, "Error: %s, line %d: assignments \"a=1 b=-2\" expected\n", file_name, line_number);
+                release_source(&source);
+                free(*envs);
+                *envs = NULL;
+                return false;
+            }
+            (*nb_envs)++;
+        }
+        line = end + 1;
+    }
+    release_source(&source);
+    return true;
+}
+
+uint64_t sweep_inputs(const t_sweep_env *envs, const int nb_envs) {
+    uint64_t inputs = 0;
+    for (int i = 0; i < nb_envs; i++)
+        inputs |= envs[i].assigned;
+    return inputs;
+}
+
+// Depth of the value stack before each instruction: the bytecode of an expression is linear, except its
+// short-circuit jumps, which leave the stack as deep as their operator; the other jumps happen between statements
+// Returns false if an instruction would read an empty stack, as the OP_ERROR of a malformed expression
+bool sweep_stack_depths(const t_bytecode *bc, int *depth) {
+    int d = 0;
+    for (int i = 0; i < bc->size; i++) {
+        depth[i] = d;
+        switch (bc->code[i].opcode) {
+            case OP_PUSH_CONST:
+            case OP_PUSH_VAR:
+                d++;
+                break;
+            case OP_STORE_VAR:
+            case OP_JUMP_IF_FALSE:
+            case OP_PRINT:
+            case OP_RETURN:
+                d--;
+                break;
+            case OP_NOT:
+            case OP_SQUARE:
+            case OP_CUBE:
+            case OP_SHL:
+            case OP_DIV_CONST:
+            case OP_AND_JUMP:
+            case OP_OR_JUMP:
+                if (d < 1)
+                    return false;
+                break;
+            case OP_JUMP:
+            case OP_PRINT_STR:
+            case OP_HALT:
+                break;
+            case OP_ERROR:
+                return false;
+            default:
+                d--;
+                if (d < 1)
+                    return false;
+                break;
+        }
+        if (d < 0 || d > bc->max_stack)
+            return false;
+    }
+    return true;
+}
+
+// Lanes (bit l for the lane l) whose value is 0
+unsigned sweep_zero_lanes(const t_lanes *value) {
+    unsigned lanes = 0;
+    for (int l = 0; l < SWEEP_WIDTH; l++)
+        lanes |= (unsigned) (LANE(*value, l) == 0) << l;
+    return lanes;
+}
+
+// Vector with all bits set in the lanes (bit l for the lane l), 0 in the others
+void sweep_lanes_mask(const unsigned lanes, t_lanes *mask) {
+    for (int l = 0; l < SWEEP_WIDTH; l++)
+        LANE(*mask, l) = -(int) ((lanes >> l) & 1);
+}
+
+// Runs the environments of the group in lockstep: the active lanes are the runs at the instruction pc, the
+// lowest of the live runs; the others wait at their own pcs[] until the active ones reach them
+// The writes are masked, so that the variables and the stack of the waiting lanes keep their values
+SWEEP_TARGETS
+void run_sweep_group(void *arg, const int group) {
+    const t_sweep *sweep = arg;
+    const t_bytecode *bc = sweep->bc;
+    const t_instr *const code = bc->code;
+    const int first = group * SWEEP_WIDTH;
+    const int nb_lanes = sweep->nb_envs - first < SWEEP_WIDTH ? sweep->nb_envs - first : SWEEP_WIDTH;
+
+    t_lanes vars[NB_SLOTS];
+    t_lanes stack[bc->max_stack + 1];
+    FILE *out[SWEEP_WIDTH];
+    int pcs[SWEEP_WIDTH];       // instruction where each lane waits
+    for (int slot = 0; slot < NB_SLOTS; slot++)
+        vars[slot] = LANES_ZERO;
+    for (int l = 0; l < SWEEP_WIDTH; l++) {
+        out[l] = NULL;
+        pcs[l] = 0;
+    }
+    for (int l = 0; l < nb_lanes; l++) {
+        for (int slot = 0; slot < NB_VARIABLES; slot++)
+            LANE(vars[slot], l) = sweep->envs[first + l].value[slot];
+        t_sweep_run *run = &sweep->runs[first + l];
+        out[l] = open_memstream(&run->output, &run->output_size);
+    }
+    for (int i = 0; i <= bc->max_stack; i++)
+        stack[i] = LANES_ZERO;
+
+    unsigned live = nb_lanes == 32 ? ~0u : (1u << nb_lanes) - 1;
+    unsigned active = live;
+    t_lanes full;               // all bits set in the active lanes
+    sweep_lanes_mask(active, &full);
+    t_lanes *sp = stack;
+    int pc = 0;                 // next instruction of the active lanes
+    int jump_pc = 0;            // next instruction of the taken lanes
+    unsigned taken = 0;         // active lanes that take the jump
+    int next_wait = INT_MAX;    // lowest pc of the waiting lanes
+
+#ifdef SWEEP_COMPUTED_GOTO
+    // Not static: the function is compiled once per processor (target_clones)
+    const void *const labels[NB_OPCODES] = {
+        &&L_OP_PUSH_CONST, &&L_OP_PUSH_VAR, &&L_OP_STORE_VAR,
+        &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MULT, &&L_OP_DIV, &&L_OP_EXP,
+        &&L_OP_EQUAL, &&L_OP_DIFF, &&L_OP_LESS, &&L_OP_GREATER, &&L_OP_LEQ, &&L_OP_GEQ,
+        &&L_OP_AND, &&L_OP_OR, &&L_OP_NOT, &&L_OP_XOR,
+        &&L_OP_SQUARE, &&L_OP_CUBE, &&L_OP_SHL, &&L_OP_DIV_CONST,
+        &&L_OP_JUMP, &&L_OP_JUMP_IF_FALSE,
+        &&L_OP_AND_JUMP, &&L_OP_OR_JUMP,
+        &&L_OP_PRINT, &&L_OP_PRINT_STR, &&L_OP_RETURN, &&L_OP_HALT,
+        &&L_OP_ERROR
+    };
+    SWEEP_DISPATCH();
+#else
+    for (;;) {
+        switch (code[pc].opcode) {
+#endif
+            SWEEP_CASE(OP_PUSH_CONST) {
+                *sp = LANES_BLEND(full, LANES_SPLAT(code[pc].arg), *sp);
+                sp++;
+                SWEEP_NEXT();
+            }
+            SWEEP_CASE(OP_PUSH_VAR) {
+                *sp = LANES_BLEND(full, vars[code[pc].arg], *sp);
+                sp++;
+                SWEEP_NEXT();
+            }
+            SWEEP_CASE(OP_STORE_VAR) {
+                sp--;
+                vars[code[pc].arg] = LANES_BLEND(full, *sp, vars[code[pc].arg]);
+                SWEEP_NEXT();
+            }
+            SWEEP_BINARY_OP(OP_ADD, LANES_WRAP(a, +, b))
+            SWEEP_BINARY_OP(OP_SUB, LANES_WRAP(a, -, b))
+            SWEEP_BINARY_OP(OP_MULT, LANES_WRAP(a, *, b))
+            // A zero divisor stops the run of its lane; it is replaced by 1 in the vector division
+            SWEEP_CASE(OP_DIV) {
+                sp--;
+                const t_lanes a = sp[-1];
+                const t_lanes b = *sp;
+                const unsigned zero = sweep_zero_lanes(&b) & active;
+                for (int l = 0; l < SWEEP_WIDTH; l++) {
+                    if (zero & (1u << l))
+                        sweep->runs[first + l].error = true;
+                }
+                // INT_MIN / -1 wraps to INT_MIN, as the negation
+                const t_lanes minus_one = LANES_FULL(LANES_TEST(b, ==, -1));
+                const t_lanes q = LANES_DIV(a, LANES_BLEND(minus_one, LANES_SPLAT(1), b | LANES_TEST(b, ==, 0)));
+                sp[-1] = LANES_BLEND(full, LANES_BLEND(minus_one, LANES_WRAP(LANES_ZERO, -, a), q), a);
+                if (zero != 0) {
+                    live &= ~zero;
+                    active &= ~zero;
+                    sweep_lanes_mask(active, &full);
+                    pc++;
+                    goto branch;
+                }
+                SWEEP_NEXT();
+            }
+            SWEEP_CASE(OP_EXP) {
+                sp--;
+                for (int l = 0; l < SWEEP_WIDTH; l++) {
+                    if (active & (1u << l))
+                        LANE(sp[-1], l) = fast_exp(LANE(sp[-1], l), LANE(*sp, l));
+                }
+                SWEEP_NEXT();
+            }
+            SWEEP_BINARY_OP(OP_EQUAL, LANES_TEST(a, ==, b))
+            SWEEP_BINARY_OP(OP_DIFF, LANES_TEST(a, !=, b))
+            SWEEP_BINARY_OP(OP_LESS, LANES_TEST(a, <, b))
+            SWEEP_BINARY_OP(OP_GREATER, LANES_TEST(a, >, b))
+            SWEEP_BINARY_OP(OP_LEQ, LANES_TEST(a, <=, b))
+            SWEEP_BINARY_OP(OP_GEQ, LANES_TEST(a, >=, b))
+            SWEEP_BINARY_OP(OP_AND, LANES_TEST(a, !=, 0) & LANES_TEST(b, !=, 0))
+            SWEEP_BINARY_OP(OP_OR, LANES_TEST(a, !=, 0) | LANES_TEST(b, !=, 0))
+            SWEEP_CASE(OP_NOT) {
+                sp[-1] = LANES_BLEND(full, LANES_TEST(sp[-1], ==, 0), sp[-1]);
+                SWEEP_NEXT();
+            }
+            SWEEP_BINARY_OP(OP_XOR, LANES_TEST(a, !=, 0) ^ LANES_TEST(b, !=, 0))
+            SWEEP_CASE(OP_SQUARE) {
+                sp[-1] = LANES_BLEND(full, LANES_WRAP(sp[-1], *, sp[-1]), sp[-1]);
+                SWEEP_NEXT();
+            }
+            SWEEP_CASE(OP_CUBE) {
+                sp[-1] = LANES_BLEND(full, LANES_WRAP(LANES_WRAP(sp[-1], *, sp[-1]), *, sp[-1]), sp[-1]);
+                SWEEP_NEXT();
+            }
+            SWEEP_CASE(OP_SHL) {
+                sp[-1] = LANES_BLEND(full, (t_lanes) ((t_ulanes) sp[-1] << code[pc].arg), sp[-1]);
+                SWEEP_NEXT();
+            }
+            SWEEP_CASE(OP_DIV_CONST) {
+                // apply_div_const() on the lanes, with the magic number and the shift of the division table
+                const t_div_const *div = &bc->divs[code[pc].arg];
+                const t_lanes a = sp[-1];
+                t_lanes q;
+                if (div->magic == 0) {
+                    q = (a + ((a >> 31) & (int) ((1u << div->shift) - 1))) >> div->shift;
+                    if (div->divisor < 0)
+                        q = LANES_ZERO - q;
+                } else {
+                    q = LANES_MULH(a, div->magic);
+                    if (div->divisor > 0 && div->magic < 0)
+                        q = LANES_WRAP(q, +, a);
+                    else if (div->divisor < 0 && div->magic > 0)
+                        q = LANES_WRAP(q, -, a);
+                    q = q >> div->shift;
+                    q = q + (t_lanes) ((t_ulanes) q >> 31);
+                }
+                sp[-1] = LANES_BLEND(full, q, sp[-1]);
+                SWEEP_NEXT();
+            }
+
+            // A jump keeps the depth of the stack: the depth at its target is the depth after the jump
+            SWEEP_CASE(OP_JUMP) {
+                pc = code[pc].arg;
+                if (pc < next_wait)
+                    SWEEP_DISPATCH();
+                goto reschedule;
+            }
+            SWEEP_CASE(OP_JUMP_IF_FALSE) {
+                sp--;
+                taken = sweep_zero_lanes(sp) & active;
+                jump_pc = code[pc++].arg;
+                goto branch;
+            }
+            SWEEP_CASE(OP_AND_JUMP) {
+                taken = sweep_zero_lanes(&sp[-1]) & active;
+                jump_pc = code[pc++].arg;
+                goto branch;
+            }
+            SWEEP_CASE(OP_OR_JUMP) {
+                taken = ~sweep_zero_lanes(&sp[-1]) & active;
+                t_lanes taken_full;
+                sweep_lanes_mask(taken, &taken_full);
+                sp[-1] = LANES_BLEND(taken_full, LANES_SPLAT(1), sp[-1]);
+                jump_pc = code[pc++].arg;
+                goto branch;
+            }
+
+            SWEEP_CASE(OP_PRINT) {
+                sp--;
+                for (int l = 0; l < SWEEP_WIDTH; l++) {
+                    if (active & (1u << l))
+                        fprintf(out[l], "%d\n", LANE(*sp, l));
+                }
+                SWEEP_NEXT();
+            }
+            SWEEP_CASE(OP_PRINT_STR) {
+                for (int l = 0; l < SWEEP_WIDTH; l++) {
+                    if (active & (1u << l))
+                        fprintf(out[l], "%s\n", bc->strings + code[pc].arg);
+                }
+                SWEEP_NEXT();
+            }
+            SWEEP_CASE(OP_RETURN) {
+                sp--;
+                for (int l = 0; l < SWEEP_WIDTH; l++) {
+                    if (active & (1u << l))
+                        fprintf(out[l], "-> %d\n", LANE(*sp, l));
+                }
+                live &= ~active;
+                active = 0;
+                goto reschedule;
+            }
+            // OP_ERROR is never run: sweep_stack_depths() rejects the bytecode of a malformed expression
+            SWEEP_CASE(OP_ERROR)
+            SWEEP_CASE(OP_HALT) {
+                live &= ~active;
+                active = 0;
+                goto reschedule;
+            }
+#ifndef SWEEP_COMPUTED_GOTO
+        }
+#endif
+
+    branch:
+        // The active lanes stay together if they all take the jump or none does, and reach no waiting lane
+        if (taken != 0 && taken == active) {
+            pc = jump_pc;
+            taken = 0;
+        }
+        if (taken == 0 && active != 0 && pc < next_wait)
+            SWEEP_DISPATCH();
+        // The lanes that jump forward wait at the target, the others go on
+        if (taken != 0 && jump_pc > pc && pc < next_wait) {
+            for (int l = 0; l < SWEEP_WIDTH; l++) {
+                if (taken & (1u << l))
+                    pcs[l] = jump_pc;
+            }
+            active &= ~taken;
+            taken = 0;
+            if (jump_pc < next_wait)
+                next_wait = jump_pc;
+            sweep_lanes_mask(active, &full);
+            SWEEP_DISPATCH();
+        }
+
+    reschedule:
+        // The active lanes split or reach waiting lanes: the live lanes of the lowest pc run next
+        for (int l = 0; l < SWEEP_WIDTH; l++) {
+            if (active & (1u << l))
+                pcs[l] = taken & (1u << l) ? jump_pc : pc;
+        }
+        taken = 0;
+        if (live == 0)
+            goto done;
+        pc = INT_MAX;
+        for (int l = 0; l < SWEEP_WIDTH; l++) {
+            if ((live & (1u << l)) && pcs[l] < pc)
+                pc = pcs[l];
+        }
+        active = 0;
+        next_wait = INT_MAX;
+        for (int l = 0; l < SWEEP_WIDTH; l++) {
+            if (!(live & (1u << l)))
+                continue;
+            if (pcs[l] == pc)
+                active |= 1u << l;
+            else if (pcs[l] < next_wait)
+                next_wait = pcs[l];
+        }
+        sweep_lanes_mask(active, &full);
+        sp = stack + sweep->depth[pc];
+        SWEEP_DISPATCH();
+#ifndef SWEEP_COMPUTED_GOTO
+    }
+#endif
+
+done:
+    for (int l = 0; l < nb_lanes; l++)
+        fclose(out[l]);
+}
+
+void print_sweep_env(FILE *file, const t_sweep_env *env) {
+    for (int slot = 0; slot < NB_VARIABLES; slot++) {
+        if (env->assigned & ((uint64_t) 1 << slot))
+            fprintf(file, " %c=%d", 'a' + slot, env->value[slot]);
+    }
+}
+
+int run_sweep(const t_bytecode *bc, const t_sweep_env *envs, const int nb_envs, const int nb_threads) {
+    int *depth = malloc((bc->size + 1) * sizeof(int));
+    if (!sweep_stack_depths(bc, depth)) {
+        fprintf(stderr, "Error: the bytecode reads an empty stack, it cannot be swept\n");
+        free(depth);
+        return nb_envs;
+    }
+    t_sweep sweep = { .bc = bc, .depth = depth, .envs = envs, .nb_envs = nb_envs };
+    sweep.runs = malloc(nb_envs * sizeof(t_sweep_run));
+    for (int i = 0; i < nb_envs; i++) {
+        sweep.runs[i].output = NULL;
+        sweep.runs[i].output_size = 0;
+        sweep.runs[i].error = false;
+    }
+
+    const int nb_groups = (nb_envs + SWEEP_WIDTH - 1) / SWEEP_WIDTH;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    run_parallel_tasks(nb_groups, nb_threads, run_sweep_group, &sweep);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    // Outputs, in the order of the environments
+    for (int i = 0; i < nb_envs; i++) {
+        fprintf(stdout, "==>");
+        print_sweep_env(stdout, &envs[i]);
+        fprintf(stdout, " <==\n");
+        fwrite(sweep.runs[i].output, 1, sweep.runs[i].output_size, stdout);
+    }
+    fflush(stdout);
+
+    // Summary
+    int nb_failed = 0;
+    for (int i = 0; i < nb_envs; i++) {
+        if (sweep.runs[i].error) {
+            fprintf(stderr, "Division by zero:");
+            print_sweep_env(stderr, &envs[i]);
+            fprintf(stderr, "\n");
+        }
+        nb_failed += sweep.runs[i].error;
+        free(sweep.runs[i].output);
+    }
+    fprintf(stderr, "%d runs, %d failed, %d lanes per vector, %d threads, %.3f ms\n", nb_envs, nb_failed,
+            SWEEP_WIDTH, nb_threads < nb_groups ? nb_threads : nb_groups, sweep_elapsed_ms(&start, &end));
+
+    free(sweep.runs);
+    free(depth);
+    return nb_failed;
+}
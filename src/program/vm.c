@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "program/vm.h"
+#include "program/error.h"
+
+// Computed-goto dispatch (GCC/Clang "labels as values"), switch dispatch otherwise
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO
+#endif
+
+#ifdef VM_COMPUTED_GOTO
+#define VM_CASE(opcode) L_##opcode:
+#define VM_DISPATCH() goto *labels[ip->opcode]
+#else
+#define VM_CASE(opcode) case opcode:
+#define VM_DISPATCH() continue
+#endif
+
+#define VM_BINARY_OP(opcode, expr)      \
+    VM_CASE(opcode) {                   \
+        const int b = *--sp;            \
+        const int a = sp[-1];           \
+        sp[-1] = (expr);                \
+        ip++;                           \
+        VM_DISPATCH();                  \
+    }
+
+void run_vm(const t_bytecode *bc, FILE *out) {
+    int var_value[NB_SLOTS];
+    for (int i = 0; i < NB_SLOTS; i++) {
+        var_value[i] = 0;
+    }
+    int stack[bc->max_stack + 1];
+    int *sp = stack;
+    const t_instr *ip = bc->code;
+
+#ifdef VM_COMPUTED_GOTO
+    static const void *labels[NB_OPCODES] = {
+        &&L_OP_PUSH_CONST, &&L_OP_PUSH_VAR, &&L_OP_STORE_VAR,
+        &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MULT, &&L_OP_DIV, &&L_OP_EXP,
+        &&L_OP_EQUAL, &&L_OP_DIFF, &&L_OP_LESS, &&L_OP_GREATER, &&L_OP_LEQ, &&L_OP_GEQ,
+        &&L_OP_AND, &&L_OP_OR, &&L_OP_NOT, &&L_OP_XOR,
+        &&L_OP_SQUARE, &&L_OP_CUBE, &&L_OP_SHL, &&L_OP_DIV_CONST,
+        &&L_OP_JUMP, &&L_OP_JUMP_IF_FALSE,
+        &&L_OP_AND_JUMP, &&L_OP_OR_JUMP,
+        &&L_OP_PRINT, &&L_OP_PRINT_STR, &&L_OP_RETURN, &&L_OP_HALT,
+        &&L_OP_ERROR
+    };
+    VM_DISPATCH();
+#else
+    for (;;) {
+        switch (ip->opcode) {
+#endif
+            VM_CASE(OP_PUSH_CONST) {
+                *sp++ = ip->arg;
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_PUSH_VAR) {
+                *sp++ = var_value[ip->arg];
+                ip++;
+                VM_DISPATCH();
+            }
+            // The stack is empty after the value of an expression is used: the values a malformed expression
+            // leaves under its result are dropped, eval_rpn() returns the top
+            VM_CASE(OP_STORE_VAR) {
+                var_value[ip->arg] = sp[-1];
+                sp = stack;
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_BINARY_OP(OP_ADD, a + b)
+            VM_BINARY_OP(OP_SUB, a - b)
+            VM_BINARY_OP(OP_MULT, a * b)
+            VM_CASE(OP_DIV) {
+                const int b = *--sp;
+                if (b == 0) {
+                    fprintf(error_stream(), "Division by zero\n");
+                    program_error();
+                }
+                sp[-1] = sp[-1] / b;
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_BINARY_OP(OP_EXP, fast_exp(a, b))
+            VM_BINARY_OP(OP_EQUAL, a == b)
+            VM_BINARY_OP(OP_DIFF, a != b)
+            VM_BINARY_OP(OP_LESS, a < b)
+            VM_BINARY_OP(OP_GREATER, a > b)
+            VM_BINARY_OP(OP_LEQ, a <= b)
+            VM_BINARY_OP(OP_GEQ, a >= b)
+            VM_BINARY_OP(OP_AND, a && b)
+            VM_BINARY_OP(OP_OR, a || b)
+            VM_BINARY_OP(OP_XOR, (a != 0) != (b != 0))
+            VM_CASE(OP_NOT) {
+                sp[-1] = !sp[-1];
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_SQUARE) {
+                sp[-1] *= sp[-1];
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_CUBE) {
+                sp[-1] *= sp[-1] * sp[-1];
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_SHL) {
+                sp[-1] = (int) ((unsigned) sp[-1] << ip->arg);
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_DIV_CONST) {
+                // Magic number and shift of the division table: no division instruction, no test of the divisor
+                sp[-1] = apply_div_const(&bc->divs[ip->arg], sp[-1]);
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_JUMP) {
+                ip = bc->code + ip->arg;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_JUMP_IF_FALSE) {
+                const int cond = sp[-1];
+                sp = stack;
+                if (cond)
+                    ip++;
+                else
+                    ip = bc->code + ip->arg;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_AND_JUMP) {
+                if (sp[-1])
+                    ip++;
+                else
+                    ip = bc->code + ip->arg;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_OR_JUMP) {
+                if (sp[-1]) {
+                    sp[-1] = 1;
+                    ip = bc->code + ip->arg;
+                } else {
+                    ip++;
+                }
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_PRINT) {
+                fprintf(out, "%d\n", sp[-1]);
+                sp = stack;
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_PRINT_STR) {
+                fprintf(out, "%s\n", bc->strings + ip->arg);
+                ip++;
+                VM_DISPATCH();
+            }
+            VM_CASE(OP_RETURN) {
+                fprintf(out, "-> %d\n", sp[-1]);
+                return;
+            }
+            VM_CASE(OP_HALT) {
+                return;
+            }
+            VM_CASE(OP_ERROR) {
+                fprintf(error_stream(), "%s", bc->strings + ip->arg);
+                program_error();
+            }
+#ifndef VM_COMPUTED_GOTO
+            default:
+                fprintf(error_stream(), "run_vm: unknown opcode %d\n", ip->opcode);
+                program_error();
+        }
+    }
+#endif
+}
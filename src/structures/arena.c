@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "structures/arena.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN (sizeof(max_align_t))
+
+t_arena create_arena() {
+    t_arena arena;
+    arena.head = NULL;
+    arena.bytes_used = 0;
+    arena.peak_bytes_used = 0;
+    arena.bytes_reserved = 0;
+    return arena;
+}
+
+// Adds a new block of at least min_capacity bytes at the head of the arena
+void arena_add_block(t_arena *arena, const size_t min_capacity) {
+    const size_t capacity = min_capacity > ARENA_BLOCK_SIZE ? min_capacity : ARENA_BLOCK_SIZE;
+    t_arena_block *block = malloc(sizeof(t_arena_block) + capacity);
+    if (block == NULL) {
+        fprintf(stderr, "arena_alloc: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    block->capacity = capacity;
+    block->used = 0;
+    block->next = arena->head;
+    arena->head = block;
+    arena->bytes_reserved += capacity;
+}
+
+void *arena_alloc(t_arena *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (size == 0)
+        size = ARENA_ALIGN;
+    if (arena->head == NULL || arena->head->capacity - arena->head->used < size) {
+        arena_add_block(arena, size);
+    }
+    void *p = (char *) arena->head->data + arena->head->used;
+    arena->head->used += size;
+    arena->bytes_used += size;
+    if (arena->bytes_used > arena->peak_bytes_used)
+        arena->peak_bytes_used = arena->bytes_used;
+    return p;
+}
+
+char *arena_strndup(t_arena *arena, const char *s, const size_t length) {
+    char *copy = arena_alloc(arena, length + 1);
+    memcpy(copy, s, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void arena_merge(t_arena *arena, t_arena *other) {
+    if (other->head == NULL)
+        return;
+    if (arena->head == NULL) {
+        arena->head = other->head;
+    } else {
+        // Inserted after the head, which stays the block used for allocations
+        t_arena_block *last = other->head;
+        while (last->next != NULL)
+            last = last->next;
+        last->next = arena->head->next;
+        arena->head->next = other->head;
+    }
+    arena->bytes_used += other->bytes_used;
+    arena->bytes_reserved += other->bytes_reserved;
+    if (arena->bytes_used > arena->peak_bytes_used)
+        arena->peak_bytes_used = arena->bytes_used;
+    *other = create_arena();
+}
+
+void arena_reset(t_arena *arena) {
+    if (arena->head == NULL)
+        return;
+    // The oldest block is the last one of the chain
+    t_arena_block *block = arena->head;
+    while (block->next != NULL) {
+        t_arena_block *next = block->next;
+        arena->bytes_reserved -= block->capacity;
+        free(block);
+        block = next;
+    }
+    block->used = 0;
+    arena->head = block;
+    arena->bytes_used = 0;
+}
+
+void print_arena_stats(FILE *file, const t_arena *arena) {
+    fprintf(file, "arena: %zu bytes used, %zu bytes peak, %zu bytes reserved\n",
+            arena->bytes_used, arena->peak_bytes_used, arena->bytes_reserved);
+}
+
+void destroy_arena(t_arena *arena) {
+    t_arena_block *block = arena->head;
+    while (block != NULL) {
+        t_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->bytes_used = 0;
+    arena->bytes_reserved = 0;
+}
@@ -8,6 +8,13 @@ t_list create_empty_list() {
     l.head = NULL;
     l.tail = NULL;
     l.size = 0;
+    l.arena = NULL;
+    return l;
+}
+
+t_list create_empty_arena_list(t_arena *arena) {
+    t_list l = create_empty_list();
+    l.arena = arena;
     return l;
 }
 
@@ -15,8 +22,10 @@ int length(const t_list *list) {
     return list->size;
 }
 
-t_cell *create_cell(T val) {
-    t_cell *newcell = (t_cell*) malloc(sizeof(t_cell));
+t_cell *create_cell(const t_list *list, T val) {
+    t_cell *newcell = list->arena != NULL
+        ? (t_cell*) arena_alloc(list->arena, sizeof(t_cell))
+        : (t_cell*) malloc(sizeof(t_cell));
     newcell->value = val;
     newcell->next = NULL;
     return newcell;
@@ -25,7 +34,7 @@ t_cell *create_cell(T val) {
 // O(1)
 void push_front(t_list *list, T val) {
     
-    t_cell *newcell = create_cell(val);
+    t_cell *newcell = create_cell(list, val);
     newcell->next = list->head;
     list->head = newcell;
     list->size++;
@@ -67,7 +76,7 @@ void push_back(t_list *list, T val) {
         push_front(list, val);
         return;
     }
-    t_cell *newcell = create_cell(val);
+    t_cell *newcell = create_cell(list, val);
     t_cell *lastcell = get_last(list);
     lastcell->next = newcell;
     list->tail = newcell;
@@ -95,7 +104,7 @@ void insert(t_list *list, int index, T val) {
     }
 
     t_cell *prev = get_cell(list, index - 1);
-    t_cell *newcell = create_cell(val);
+    t_cell *newcell = create_cell(list, val);
     newcell->next = prev->next;
     prev->next = newcell;
     list->size++;
@@ -109,7 +118,8 @@ void delete_at(t_list *list, int index) {
         if (first == NULL)
             return;
         list->head = first->next;
-        free(first);
+        if (list->arena == NULL)
+            free(first);
         list->size--;
         if (list->size == 0)
             list->tail = NULL;
@@ -122,7 +132,8 @@ void delete_at(t_list *list, int index) {
         return;
 
     t_cell *next = cell->next;
-    free(cell);
+    if (list->arena == NULL)
+        free(cell);
     prev->next = next;
     list->size--;
     
@@ -153,7 +164,8 @@ void print_list_file(FILE *file, const t_list *list) {
 
 void destroy_list(t_list *list) {
 
-    t_cell *cell = list->head;
+    // Cells allocated in an arena are released with the arena
+    t_cell *cell = list->arena == NULL ? list->head : NULL;
     while (cell != NULL) {
         t_cell *next = cell->next;
         free(cell);
@@ -101,7 +101,7 @@ void ptl_print_list(const t_prog_token_list *list) {
 
 void ptl_destroy_list(t_prog_token_list *list) {
     // Do not destroy the expr_rpn in list->data[i], because the expr_rpn are copied into the ast
-    // destroy_ast destroys them
+    // They are allocated in the arena given to lex(), and released with it
     free(list->data);
     list->data = NULL;
     list->size = 0;
@@ -0,0 +1,93 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "structures/task_pool.h"
+
+typedef struct {
+    t_task_pool *pool;
+    int id;
+} t_worker;
+
+// Takes the next task of the deque of the thread, returns -1 if it is empty
+int take_own_task(t_task_deque *deque) {
+    int index = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->front < deque->back)
+        index = deque->front++;
+    pthread_mutex_unlock(&deque->lock);
+    return index;
+}
+
+// Takes the last task of the deque of another thread, returns -1 if it is empty
+int steal_task(t_task_deque *deque) {
+    int index = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->front < deque->back)
+        index = --deque->back;
+    pthread_mutex_unlock(&deque->lock);
+    return index;
+}
+
+void *worker_loop(void *p_worker) {
+    const t_worker *worker = p_worker;
+    t_task_pool *pool = worker->pool;
+
+    while (true) {
+        int index = take_own_task(&pool->deques[worker->id]);
+        // No task is ever added: when every deque is empty, the work is done
+        for (int i = 1; index < 0 && i < pool->nb_threads; i++) {
+            index = steal_task(&pool->deques[(worker->id + i) % pool->nb_threads]);
+        }
+        if (index < 0)
+            break;
+        pool->task(pool->arg, index);
+    }
+    return NULL;
+}
+
+void run_parallel_tasks(const int nb_tasks, int nb_threads, void (*task)(void *arg, int index), void *arg) {
+    if (nb_tasks <= 0)
+        return;
+    if (nb_threads > nb_tasks)
+        nb_threads = nb_tasks;
+    if (nb_threads < 1)
+        nb_threads = 1;
+
+    t_task_pool pool;
+    pool.deques = malloc(nb_threads * sizeof(t_task_deque));
+    pool.nb_threads = nb_threads;
+    pool.task = task;
+    pool.arg = arg;
+    for (int i = 0; i < nb_threads; i++) {
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+        pool.deques[i].front = (int) ((long) nb_tasks * i / nb_threads);
+        pool.deques[i].back = (int) ((long) nb_tasks * (i + 1) / nb_threads);
+    }
+
+    t_worker *workers = malloc(nb_threads * sizeof(t_worker));
+    pthread_t *threads = malloc(nb_threads * sizeof(pthread_t));
+    for (int i = 0; i < nb_threads; i++) {
+        workers[i].pool = &pool;
+        workers[i].id = i;
+    }
+    for (int i = 1; i < nb_threads; i++) {
+        pthread_create(&threads[i], NULL, worker_loop, &workers[i]);
+    }
+    worker_loop(&workers[0]);
+    for (int i = 1; i < nb_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int i = 0; i < nb_threads; i++) {
+        pthread_mutex_destroy(&pool.deques[i].lock);
+    }
+    free(threads);
+    free(workers);
+    free(pool.deques);
+}
+
+int nb_available_cores() {
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int) n : 1;
+}